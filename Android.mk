@@ -12,30 +12,41 @@ LOCAL_C_INCLUDES := jni/flixel/include \
 	jni/SDL_mixer \
 	jni/angelscript/include
 	
-LOCAL_SRC_FILES := FlxButton.cpp \
+LOCAL_SRC_FILES := FlxBackendBase.cpp \
+	FlxBoxes.cpp \
+	FlxButton.cpp \
 	FlxEmitter.cpp \
 	FlxG.cpp \
 	FlxGroup.cpp \
+	FlxHandles.cpp \
+	FlxJobs.cpp \
+	FlxKinematics.cpp \
 	FlxKeyboard.cpp \
 	FlxMouse.cpp \
 	FlxMusic.cpp \
 	FlxObject.cpp \
 	FlxPreloader.cpp \
+	FlxProfiler.cpp \
+	FlxQuadTree.cpp \
+	FlxRenderer.cpp \
 	FlxSave.cpp \
 	FlxSound.cpp \
+	FlxSpatialHash.cpp \
 	FlxSprite.cpp \
 	FlxText.cpp \
 	FlxTilemap.cpp \
+	FlxTimestep.cpp \
 	FlxHttpRequest.cpp \
 	FlxMouseHolder.cpp \
 	FlxShader.cpp \
 	FlxU.cpp \
 	FlxVirtualKeyboard.cpp \
+	FlxWorld.cpp \
 	FlxScript.cpp \
 	tweener/CppTween.cpp \
 	backend/sdl_mobile/Backend.cpp
 
-LOCAL_CFLAGS := -DFLX_MOBILE --std=gnu++0x
+LOCAL_CFLAGS := -DFLX_MOBILE -DFLX_NO_THREADS --std=gnu++0x
 LOCAL_LDLIBS := -llog
 LOCAL_STATIC_LIBRARIES := libangelscript
 
@@ -0,0 +1,782 @@
+/*
+   This file is a part of "Flixel C++ port" project
+   Copyrights (c) by Michał Korman 2012
+*/
+
+/*
+*  Benchmark suite.
+*  Runs a set of stress scenes on headless backend and prints results as JSON, so runs
+*  on different machines/commits can be compared with simple scripts.
+*
+*  Build it like any other sample, together with core sources (src/ and src/tweener/) and
+*  headless backend (src/backend/headless/Backend.cpp). Example for GCC:
+*     g++ -std=gnu++0x -O2 -DFLX_NO_SCRIPT -Iinclude -Isrc benchmarks/FlxBenchmark.cpp <sources> -o FlxBenchmark
+*
+*  Usage:
+*     FlxBenchmark [--scene name] [--frames n] [--warmup n] [--scale n] [--seed n] [--pipelined]
+*
+*  Every scene is seeded, so two runs with the same arguments simulate exactly the same world.
+*  With --pipelined draw calls are recorded and submitted on render thread (FlxG::renderer),
+*  then update_ns and draw_ns overlap.
+*  Reported values:
+*     - update_ns / draw_ns     - average time of update/draw per frame (in nanoseconds)
+*     - allocations             - average count of heap allocations per frame
+*     - draw_calls / texture_switches - average renderer load per frame
+*  After all scenes peak_rss_kb (peak resident memory of the whole process) is printed once.
+*  It's the maximum of all run scenes, so for memory of single scene run it with --scene.
+*/
+#include <FlxG.h>
+#include <FlxSprite.h>
+#include <FlxTilemap.h>
+#include <FlxEmitter.h>
+#include <FlxPath.h>
+#include <FlxKinematics.h>
+#include <FlxWorld.h>
+#include <backend/headless/Backend.h>
+
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+    #include <windows.h>
+    #include <psapi.h>
+#else
+    #include <sys/resource.h>
+#endif
+
+
+/*
+*  Allocations counter (every operator new goes through here).
+*  All replaceable allocation functions are defined and kept out of line, so every delete
+*  matches the new it came from (GCC checks it with -Wmismatched-new-delete).
+*/
+#ifdef __GNUC__
+    #define BENCH_NOINLINE __attribute__((noinline))
+#else
+    #define BENCH_NOINLINE
+#endif
+
+static std::atomic<unsigned long long> AllocationsCount(0);
+
+static void* countedAlloc(size_t size) {
+    AllocationsCount++;
+
+    void *ptr = malloc(size ? size : 1);
+    if(!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+BENCH_NOINLINE void* operator new(size_t size) {
+    return countedAlloc(size);
+}
+
+BENCH_NOINLINE void* operator new[](size_t size) {
+    return countedAlloc(size);
+}
+
+BENCH_NOINLINE void operator delete(void *ptr) throw() {
+    free(ptr);
+}
+
+BENCH_NOINLINE void operator delete[](void *ptr) throw() {
+    free(ptr);
+}
+
+#ifdef __cpp_sized_deallocation
+BENCH_NOINLINE void operator delete(void *ptr, size_t) throw() {
+    free(ptr);
+}
+
+BENCH_NOINLINE void operator delete[](void *ptr, size_t) throw() {
+    free(ptr);
+}
+#endif
+
+#ifdef __cpp_aligned_new
+static void* countedAlignedAlloc(size_t size, std::align_val_t align) {
+    AllocationsCount++;
+
+#ifdef _WIN32
+    void *ptr = _aligned_malloc(size ? size : 1, (size_t) align);
+#else
+    void *ptr = NULL;
+    if(posix_memalign(&ptr, (size_t) align, size ? size : 1) != 0) ptr = NULL;
+#endif
+
+    if(!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+static void alignedFree(void *ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+BENCH_NOINLINE void* operator new(size_t size, std::align_val_t align) {
+    return countedAlignedAlloc(size, align);
+}
+
+BENCH_NOINLINE void* operator new[](size_t size, std::align_val_t align) {
+    return countedAlignedAlloc(size, align);
+}
+
+BENCH_NOINLINE void operator delete(void *ptr, std::align_val_t) throw() {
+    alignedFree(ptr);
+}
+
+BENCH_NOINLINE void operator delete[](void *ptr, std::align_val_t) throw() {
+    alignedFree(ptr);
+}
+
+BENCH_NOINLINE void operator delete(void *ptr, size_t, std::align_val_t) throw() {
+    alignedFree(ptr);
+}
+
+BENCH_NOINLINE void operator delete[](void *ptr, size_t, std::align_val_t) throw() {
+    alignedFree(ptr);
+}
+#endif
+
+
+/*
+*  Get peak resident set size of process (in kilobytes)
+*/
+static unsigned long long getPeakRss() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize / 1024;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+
+    #ifdef __APPLE__
+        return usage.ru_maxrss / 1024;
+    #else
+        return usage.ru_maxrss;
+    #endif
+#endif
+}
+
+
+/*
+*  Scenes configuration (set from command line)
+*/
+static int BenchScale = 1;
+
+// FlxG::setup() reseeds generator with current time, so every scene seeds it again in create()
+static unsigned int BenchSeed = 1337;
+
+// record draw calls and render them on render thread
+static bool BenchPipelined = false;
+
+#define BENCH_SPRITE "bench/sprite.png"
+#define BENCH_TILES "bench/tiles.png"
+
+
+/*
+*  Sprite bouncing from screen edges
+*/
+class BenchMover : public FlxSprite {
+
+public:
+    BenchMover(float X, float Y) : FlxSprite(X, Y, BENCH_SPRITE) {
+        velocity.x = FlxU::random(-100, 100);
+        velocity.y = FlxU::random(-100, 100);
+    }
+
+    virtual void update() {
+        FlxSprite::update();
+
+        if((x < 0 && velocity.x < 0) || (x + width > FlxG::width && velocity.x > 0)) velocity.x = -velocity.x;
+        if((y < 0 && velocity.y < 0) || (y + height > FlxG::height && velocity.y > 0)) velocity.y = -velocity.y;
+    }
+};
+
+
+/*
+*  Many independent sprites: update and draw throughput
+*/
+class SpritesScene : public FlxState {
+
+public:
+    virtual void create() {
+        srand(BenchSeed);
+
+        for(int i = 0; i < 10000 * BenchScale; i++) {
+            add(new BenchMover(FlxU::random(0, FlxG::width - 16), FlxU::random(0, FlxG::height - 16)));
+        }
+    }
+};
+
+
+/*
+*  The same sprites drawn in order of their bottom edges (top-down games)
+*/
+class SortedSpritesScene : public SpritesScene {
+
+public:
+    virtual void create() {
+        SpritesScene::create();
+        sortMode = FLX_SORT_Y;
+    }
+};
+
+
+/*
+*  The same sprites in tree of nested groups (10 layers of 10 groups)
+*/
+class NestedSpritesScene : public FlxState {
+
+public:
+    virtual void create() {
+        srand(BenchSeed);
+
+        for(int i = 0; i < 10; i++) {
+            FlxGroup *layer = new FlxGroup();
+            layer->flattenDraw = true;
+
+            for(int j = 0; j < 10; j++) {
+                FlxGroup *group = new FlxGroup();
+                group->flattenDraw = true;
+
+                for(int k = 0; k < 100 * BenchScale; k++) {
+                    group->add(new BenchMover(FlxU::random(0, FlxG::width - 16), FlxU::random(0, FlxG::height - 16)));
+                }
+
+                layer->add(group);
+            }
+
+            add(layer);
+        }
+    }
+};
+
+
+/*
+*  Level 10x10 screens big full of movers, camera flies over it. Movers far from camera sleep.
+*/
+class SleepingSpritesScene : public FlxState {
+
+public:
+    virtual void create() {
+        srand(BenchSeed);
+
+        int worldWidth = FlxG::width * 10;
+        int worldHeight = FlxG::height * 10;
+        FlxG::worldBounds = FlxRect(0, 0, worldWidth, worldHeight);
+
+        FlxGroup *movers = new FlxGroup();
+        movers->sleepDistance = 64;
+
+        for(int i = 0; i < 10000 * BenchScale; i++) {
+            movers->add(new BenchMover(FlxU::random(0, worldWidth - 16), FlxU::random(0, worldHeight - 16)));
+        }
+
+        add(movers);
+
+        FlxObject *camera = new FlxObject();
+        camera->x = FlxG::width / 2;
+        camera->y = FlxG::height / 2;
+        camera->velocity.x = 400;
+        camera->velocity.y = 240;
+        add(camera);
+
+        FlxG::followObject(camera);
+    }
+};
+
+
+/*
+*  The same movers as entities of FlxWorld (bouncing is a system)
+*/
+class WorldSpritesScene : public FlxState {
+
+public:
+    virtual void create() {
+        srand(BenchSeed);
+
+        FlxWorld *world = new FlxWorld();
+        FlxBackendImage *image = FlxG::backend->loadImage(BENCH_SPRITE);
+
+        for(int i = 0; i < 10000 * BenchScale; i++) {
+            FlxEntity entity = world->create(FLX_TRANSFORM | FLX_VELOCITY | FLX_SPRITE);
+
+            FlxTransform *transform = world->get<FlxTransform>(entity);
+            transform->x = transform->lastX = FlxU::random(0, FlxG::width - 16);
+            transform->y = transform->lastY = FlxU::random(0, FlxG::height - 16);
+
+            FlxVelocity *velocity = world->get<FlxVelocity>(entity);
+            velocity->velocity.x = FlxU::random(-100, 100);
+            velocity->velocity.y = FlxU::random(-100, 100);
+
+            FlxSpriteRef *sprite = world->get<FlxSpriteRef>(entity);
+            sprite->image = image;
+            sprite->source = FlxRect(0, 0, image->getWidth(), image->getHeight());
+        }
+
+        world->addSystem(FLX_TRANSFORM | FLX_VELOCITY | FLX_SPRITE, [](FlxWorldChunk& chunk) {
+            for(unsigned int i = 0; i < chunk.count; i++) {
+                FlxTransform& t = chunk.transforms[i];
+                FlxVector& v = chunk.velocities[i].velocity;
+                const FlxRect& source = chunk.sprites[i].source;
+
+                if((t.x < 0 && v.x < 0) || (t.x + source.width > FlxG::width && v.x > 0)) v.x = -v.x;
+                if((t.y < 0 && v.y < 0) || (t.y + source.height > FlxG::height && v.y > 0)) v.y = -v.y;
+            }
+        });
+
+        add(world);
+    }
+};
+
+
+/*
+*  Big tilemap with movers colliding against it
+*/
+class TilemapScene : public FlxState {
+
+    FlxTilemap *map;
+    FlxGroup *movers;
+public:
+    virtual void create() {
+        srand(BenchSeed);
+
+        const int size = 512;
+        int *data = new int[size * size];
+
+        for(int y = 0; y < size; y++) {
+            for(int x = 0; x < size; x++) {
+                bool border = (x == 0 || y == 0 || x == size - 1 || y == size - 1);
+                data[y * size + x] = (border || FlxU::random(0, 1) < 0.2f) ? 1 : 0;
+            }
+        }
+
+        map = new FlxTilemap();
+        map->loadMap(data, size, size, BENCH_TILES, 16, 16);
+        delete[] data;
+        add(map);
+
+        FlxG::worldBounds = FlxRect(0, 0, size * 16, size * 16);
+
+        movers = new FlxGroup();
+        for(int i = 0; i < 64 * BenchScale; i++) {
+            float px = FlxU::random(16, FlxG::width - 32);
+            float py = FlxU::random(16, FlxG::height - 32);
+
+            // don't spawn movers inside walls
+            map->setTile((int)(px / 16), (int)(py / 16), 0);
+            map->setTile((int)((px + 16) / 16), (int)(py / 16), 0);
+            map->setTile((int)(px / 16), (int)((py + 16) / 16), 0);
+            map->setTile((int)((px + 16) / 16), (int)((py + 16) / 16), 0);
+
+            movers->add(new BenchMover(px, py));
+        }
+        add(movers);
+    }
+
+    virtual void update() {
+        FlxState::update();
+        FlxG::collide(movers, map);
+    }
+};
+
+
+/*
+*  Emitter spawning particles every frame (particles die after 1-2 seconds)
+*/
+class EmitterScene : public FlxState {
+
+    FlxEmitter *emitter;
+public:
+    virtual void create() {
+        srand(BenchSeed);
+
+        emitter = new FlxEmitter(FlxG::width / 2, FlxG::height / 2, FlxVector(-150, 150),
+                                 FlxVector(-150, 150), FlxVector(1, 2));
+        emitter->loadGraphic(BENCH_TILES, 16, 16, 4);
+        emitter->gravity = 100;
+        add(emitter);
+    }
+
+    virtual void update() {
+        FlxState::update();
+        emitter->emit(200 * BenchScale);
+    }
+};
+
+
+/*
+*  Batched emitter keeping over 100k live particles (particles die after 2-3 seconds)
+*/
+class BatchedEmitterScene : public FlxState {
+
+    FlxEmitter *emitter;
+public:
+    virtual void create() {
+        srand(BenchSeed);
+
+        emitter = new FlxEmitter(FlxG::width / 2, FlxG::height / 2, FlxVector(-150, 150),
+                                 FlxVector(-150, 150), FlxVector(2, 3));
+        emitter->loadGraphic(BENCH_TILES, 16, 16, 4);
+        emitter->gravity = 100;
+        emitter->setBatched(160000 * BenchScale);
+        add(emitter);
+    }
+
+    virtual void update() {
+        FlxState::update();
+        emitter->emit(800 * BenchScale);
+    }
+};
+
+
+/*
+*  Dense crowd colliding with itself
+*/
+class SelfCollideScene : public FlxState {
+
+    FlxGroup *crowd;
+public:
+    virtual void create() {
+        srand(BenchSeed);
+
+        crowd = new FlxGroup();
+
+        for(int i = 0; i < 1000 * BenchScale; i++) {
+            crowd->add(new BenchMover(FlxU::random(0, FlxG::width - 16), FlxU::random(0, FlxG::height - 16)));
+        }
+
+        add(crowd);
+    }
+
+    virtual void update() {
+        FlxState::update();
+        crowd->selfCollide();
+    }
+};
+
+
+/*
+*  Bullets against enemies, group vs group collisions (spatial hash broadphase)
+*/
+class BulletsScene : public FlxState {
+
+protected:
+    FlxGroup *bullets, *enemies;
+public:
+    virtual void create() {
+        srand(BenchSeed);
+
+        enemies = new FlxGroup();
+        bullets = new FlxGroup();
+
+        for(int i = 0; i < 500 * BenchScale; i++) {
+            enemies->add(new BenchMover(FlxU::random(0, FlxG::width - 16), FlxU::random(0, FlxG::height - 16)));
+        }
+
+        for(int i = 0; i < 2000 * BenchScale; i++) {
+            BenchMover *bullet = new BenchMover(FlxU::random(0, FlxG::width - 16), FlxU::random(0, FlxG::height - 16));
+            bullet->velocity.x *= 4;
+            bullet->velocity.y *= 4;
+            bullets->add(bullet);
+        }
+
+        add(enemies);
+        add(bullets);
+    }
+
+    virtual void update() {
+        FlxState::update();
+        FlxG::collide(bullets, enemies);
+    }
+};
+
+
+/*
+*  The same bullets with broadphase turned off (every pair is checked)
+*/
+class BruteForceBulletsScene : public BulletsScene {
+
+public:
+    virtual void create() {
+        BulletsScene::create();
+        bullets->broadphaseThreshold = 0;
+        enemies->broadphaseThreshold = 0;
+    }
+};
+
+
+/*
+*  Path finding in randomly generated mazes
+*/
+class PathfindingScene : public FlxState {
+
+    FlxTilemap *map;
+    int size;
+public:
+    virtual void create() {
+        srand(BenchSeed);
+
+        size = 129;
+        int *data = new int[size * size];
+        for(int i = 0; i < size * size; i++) data[i] = 1;
+
+        // carve maze with iterative depth-first search (cells are on odd coordinates)
+        std::vector<int> stack;
+        data[1 * size + 1] = 0;
+        stack.push_back(1 * size + 1);
+
+        while(!stack.empty()) {
+            int cell = stack.back();
+            int cx = cell % size, cy = cell / size;
+
+            int dirs[4][2] = { {2, 0}, {-2, 0}, {0, 2}, {0, -2} };
+            int possible[4], count = 0;
+
+            for(int i = 0; i < 4; i++) {
+                int nx = cx + dirs[i][0], ny = cy + dirs[i][1];
+                if(nx > 0 && ny > 0 && nx < size - 1 && ny < size - 1 && data[ny * size + nx] == 1) {
+                    possible[count++] = i;
+                }
+            }
+
+            if(count == 0) {
+                stack.pop_back();
+                continue;
+            }
+
+            int dir = possible[rand() % count];
+            int nx = cx + dirs[dir][0], ny = cy + dirs[dir][1];
+            data[(cy + dirs[dir][1] / 2) * size + (cx + dirs[dir][0] / 2)] = 0;
+            data[ny * size + nx] = 0;
+            stack.push_back(ny * size + nx);
+        }
+
+        map = new FlxTilemap();
+        map->loadMap(data, size, size, BENCH_TILES, 16, 16);
+        delete[] data;
+        add(map);
+    }
+
+    virtual void update() {
+        FlxState::update();
+
+        for(int i = 0; i < 2 * BenchScale; i++) {
+            int cells = (size - 1) / 2;
+            int sx = 1 + 2 * (rand() % cells), sy = 1 + 2 * (rand() % cells);
+            int ex = 1 + 2 * (rand() % cells), ey = 1 + 2 * (rand() % cells);
+
+            FlxPath *path = map->findPath(sx, sy, ex, ey);
+            if(path) delete path;
+        }
+    }
+};
+
+
+/*
+*  Lots of running tweens
+*/
+class TweensScene : public FlxState {
+
+public:
+    virtual void create() {
+        srand(BenchSeed);
+
+        for(int i = 0; i < 5000 * BenchScale; i++) {
+            FlxSprite *spr = new FlxSprite(FlxU::random(0, FlxG::width - 16),
+                                           FlxU::random(0, FlxG::height - 16), BENCH_SPRITE);
+            add(spr);
+
+            tween::TweenerParam param(FlxU::random(500, 1500), tween::LINEAR, tween::EASE_IN_OUT);
+            param.addProperty(&spr->x, FlxU::random(0, FlxG::width - 16));
+            param.addProperty(&spr->y, FlxU::random(0, FlxG::height - 16));
+            param.setRepeatWithReverse(1000000, true);
+            FlxG::tweener.addTween(param);
+        }
+    }
+};
+
+
+/*
+*  Scenes list
+*/
+struct BenchScene {
+    const char *name;
+    unsigned int frames, warmup;
+    FlxState* (*create)();
+};
+
+template<class T> FlxState* createScene() {
+    return new T();
+}
+
+static BenchScene Scenes[] = {
+    { "sprites", 600, 60, createScene<SpritesScene> },
+    { "sprites_sorted", 600, 60, createScene<SortedSpritesScene> },
+    { "sprites_nested", 600, 60, createScene<NestedSpritesScene> },
+    { "sprites_world", 600, 60, createScene<WorldSpritesScene> },
+    { "sprites_sleeping", 600, 60, createScene<SleepingSpritesScene> },
+    { "tilemap", 30, 5, createScene<TilemapScene> },
+    { "emitter", 600, 200, createScene<EmitterScene> },
+    { "emitter_batched", 600, 200, createScene<BatchedEmitterScene> },
+    { "selfcollide", 300, 30, createScene<SelfCollideScene> },
+    { "bullets", 300, 30, createScene<BulletsScene> },
+    { "bullets_bruteforce", 100, 10, createScene<BruteForceBulletsScene> },
+    { "pathfinding", 300, 30, createScene<PathfindingScene> },
+    { "tweens", 600, 60, createScene<TweensScene> }
+};
+
+
+/*
+*  Results of single scene
+*/
+struct BenchResult {
+    unsigned int frames;
+    unsigned long long updateTime, drawTime;
+    unsigned long long allocations;
+    unsigned long long drawCalls, textureSwitches;
+    double wallTime;
+};
+
+
+static BenchResult runScene(Headless_Backend *backend, const BenchScene& scene, unsigned int frames,
+                            unsigned int warmup, unsigned int seed)
+{
+    BenchResult result;
+    memset(&result, 0, sizeof(result));
+
+    unsigned int frame = 0;
+    unsigned long long lastAllocations = 0;
+
+    backend->resetStats();
+    backend->setMaxFrames(warmup + frames);
+    backend->setFrameCallback([&](Headless_Backend *b) {
+        unsigned long long allocations = AllocationsCount.load();
+
+        if(frame >= warmup) {
+            const Headless_Stats& stats = b->getFrameStats();
+
+            result.frames++;
+            result.updateTime += stats.updateTime;
+            result.drawTime += stats.drawTime;
+            result.drawCalls += stats.drawCalls;
+            result.textureSwitches += stats.textureSwitches;
+            result.allocations += allocations - lastAllocations;
+        }
+
+        // don't count callback's own work
+        lastAllocations = AllocationsCount.load();
+        frame++;
+    });
+
+    BenchSeed = seed;
+    FlxG::renderer.setPipelined(BenchPipelined);
+    FlxG::exitMessage = false;
+    FlxG::worldBounds = FlxRect(0, 0, 800, 480);
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    lastAllocations = AllocationsCount.load();
+
+    FlxG::setup("FlixelCpp benchmark", 800, 480, scene.create());
+
+    result.wallTime = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+    backend->setFrameCallback(nullptr);
+    return result;
+}
+
+
+static void printUsage() {
+    fprintf(stderr, "Usage: FlxBenchmark [--scene name] [--frames n] [--warmup n] [--scale n] [--seed n] [--pipelined]\n");
+    fprintf(stderr, "Scenes:");
+
+    for(unsigned int i = 0; i < sizeof(Scenes) / sizeof(Scenes[0]); i++) {
+        fprintf(stderr, " %s", Scenes[i].name);
+    }
+
+    fprintf(stderr, "\n");
+}
+
+
+int main(int argc, char *argv[]) {
+    const char *sceneName = NULL;
+    unsigned int frames = 0, seed = 1337;
+    int warmup = -1;
+
+    for(int i = 1; i < argc; i++) {
+        if(i + 1 < argc && strcmp(argv[i], "--scene") == 0) sceneName = argv[++i];
+        else if(i + 1 < argc && strcmp(argv[i], "--frames") == 0) frames = atoi(argv[++i]);
+        else if(i + 1 < argc && strcmp(argv[i], "--warmup") == 0) warmup = atoi(argv[++i]);
+        else if(i + 1 < argc && strcmp(argv[i], "--scale") == 0) BenchScale = atoi(argv[++i]);
+        else if(i + 1 < argc && strcmp(argv[i], "--seed") == 0) seed = atoi(argv[++i]);
+        else if(strcmp(argv[i], "--pipelined") == 0) BenchPipelined = true;
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if(BenchScale < 1) BenchScale = 1;
+
+    Headless_Backend *backend = new Headless_Backend();
+    backend->registerImage(BENCH_SPRITE, 16, 16);
+    backend->registerImage(BENCH_TILES, 64, 16);
+    FlxG::backend = backend;
+
+    printf("{\n");
+    printf("  \"backend\": \"%s\",\n", backend->getName().c_str());
+    printf("  \"scale\": %d,\n", BenchScale);
+    printf("  \"seed\": %u,\n", seed);
+    printf("  \"pipelined\": %s,\n", BenchPipelined ? "true" : "false");
+    printf("  \"kinematics\": \"%s\",\n", FlxKinematics::getKernelName(FlxKinematics::getKernel()));
+    printf("  \"scenes\": [");
+
+    bool first = true;
+    for(unsigned int i = 0; i < sizeof(Scenes) / sizeof(Scenes[0]); i++) {
+        const BenchScene& scene = Scenes[i];
+        if(sceneName && strcmp(sceneName, scene.name) != 0) continue;
+
+        BenchResult result = runScene(backend, scene, frames ? frames : scene.frames,
+                                      warmup >= 0 ? warmup : scene.warmup, seed);
+        unsigned int count = result.frames ? result.frames : 1;
+
+        printf("%s\n    {\n", first ? "" : ",");
+        printf("      \"name\": \"%s\",\n", scene.name);
+        printf("      \"frames\": %u,\n", result.frames);
+        printf("      \"warmup\": %u,\n", warmup >= 0 ? warmup : scene.warmup);
+        printf("      \"update_ns\": %llu,\n", result.updateTime / count);
+        printf("      \"draw_ns\": %llu,\n", result.drawTime / count);
+        printf("      \"allocations\": %.2f,\n", (double)result.allocations / count);
+        printf("      \"draw_calls\": %.2f,\n", (double)result.drawCalls / count);
+        printf("      \"texture_switches\": %.2f,\n", (double)result.textureSwitches / count);
+        printf("      \"wall_time_s\": %.3f\n", result.wallTime);
+        printf("    }");
+        fflush(stdout);
+
+        first = false;
+    }
+
+    printf("\n  ],\n");
+    printf("  \"peak_rss_kb\": %llu\n", getPeakRss());
+    printf("}\n");
+
+    delete backend;
+    FlxG::backend = NULL;
+
+    if(first) {
+        printUsage();
+        return 1;
+    }
+
+    return 0;
+}
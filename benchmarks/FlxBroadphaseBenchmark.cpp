@@ -0,0 +1,330 @@
+/*
+   This file is a part of "Flixel C++ port" project
+   Copyrights (c) by Michał Korman 2012
+*/
+
+/*
+*  Broadphase microbenchmark.
+*  Finds all overlapping pairs of hitboxes in levels of 1k, 10k and 50k objects mixing huge
+*  platforms with tiny bullets: brute force (every pair checked by FlxRect::overlaps, like plain
+*  group loops), FlxSpatialHash and FlxQuadTree (their pairs are confirmed by FlxRect::overlaps
+*  too). Objects move between iterations, so spatial hash is rebuilt and quadtree boxes are moved.
+*  Packed overlap kernels (FlxBoxes) are compared with FlxRect::overlaps() loops on the same boxes.
+*  Results are printed as JSON. It doesn't open any window, so no backend is needed.
+*
+*  Build it together with core sources (src/ and src/tweener/). Example for GCC:
+*     g++ -std=gnu++0x -O2 -pthread -DFLX_NO_SCRIPT -Iinclude -Isrc benchmarks/FlxBroadphaseBenchmark.cpp <sources> -o FlxBroadphaseBenchmark
+*
+*  Usage:
+*     FlxBroadphaseBenchmark [--iterations n] [--platforms percent]
+*
+*  Reported values (best of all iterations, in nanoseconds):
+*     - brute_ns               - all pairs checked (run once for 50k objects, it takes seconds)
+*     - hash_build_ns          - FlxSpatialHash rebuilt from all boxes
+*     - hash_pairs_ns          - every box queried in hash
+*     - quadtree_move_ns       - every box moved in FlxQuadTree
+*     - quadtree_pairs_ns      - FlxQuadTree::queryPairs()
+*     - pairs                  - count of overlapping pairs (the same for every method if "ok" is true)
+*     - rect_scan_ns           - 64 areas tested against all hitboxes by FlxRect::overlaps()
+*     - packed_<kernel>_ns     - the same by FlxBoxes::query() with scalar, SSE and AVX kernels
+*                                (null if kernel isn't supported)
+*/
+#include <FlxRect.h>
+#include <FlxSpatialHash.h>
+#include <FlxQuadTree.h>
+#include <FlxBoxes.h>
+#include <FlxKinematics.h>
+#include <FlxVector.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static unsigned long long elapsedSince(const Clock::time_point& start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+static const unsigned int LevelSizes[] = { 1000, 10000, 50000 };
+
+// brute force of bigger levels is run once
+static const unsigned int MaxBruteIterationsSize = 10000;
+
+
+// areas tested against all boxes by scans
+static const unsigned int ScanAreas = 64;
+
+
+static float randomRange(float min, float max) {
+    return min + (max - min) * (rand() / (float) RAND_MAX);
+}
+
+
+/*
+*  Level: hitboxes and their motion per iteration
+*/
+struct Level {
+    std::vector<FlxRect> rects;
+    std::vector<FlxVector> moves;
+    float size;
+
+    Level(unsigned int count, unsigned int platformsPercent) {
+        // the same density for every size
+        size = std::sqrt((float) count) * 40.f;
+
+        for(unsigned int i = 0; i < count; i++) {
+            bool platform = (unsigned int)(rand() % 100) < platformsPercent;
+
+            FlxRect rect(randomRange(0, size), randomRange(0, size));
+            rect.width = platform ? (int) randomRange(100, 1500) : (int) randomRange(2, 8);
+            rect.height = platform ? (int) randomRange(16, 64) : (int) randomRange(2, 8);
+
+            rects.push_back(rect);
+            moves.push_back(platform ? FlxVector(0, 0) : FlxVector(randomRange(-6, 6), randomRange(-6, 6)));
+        }
+    }
+
+    void step() {
+        for(unsigned int i = 0; i < rects.size(); i++) {
+            rects[i].x += moves[i].x;
+            rects[i].y += moves[i].y;
+
+            // wrap around level
+            if(rects[i].x < 0) rects[i].x += size;
+            if(rects[i].x > size) rects[i].x -= size;
+            if(rects[i].y < 0) rects[i].y += size;
+            if(rects[i].y > size) rects[i].y -= size;
+        }
+    }
+
+    FlxBox getBox(unsigned int i) const {
+        const FlxRect& r = rects[i];
+        FlxBox box = { r.x, r.y, r.x + r.width, r.y + r.height };
+        return box;
+    }
+};
+
+
+struct Result {
+    unsigned long long brute, hashBuild, hashPairs, quadtreeMove, quadtreePairs;
+    unsigned int brutePairs, hashPairsCount, quadtreePairsCount;
+
+    unsigned long long rectScan, packedScan[3];
+    unsigned int rectHits, packedHits[3];
+
+    Result() : brute(~0ULL), hashBuild(~0ULL), hashPairs(~0ULL), quadtreeMove(~0ULL), quadtreePairs(~0ULL),
+               brutePairs(0), hashPairsCount(0), quadtreePairsCount(0), rectScan(~0ULL), rectHits(0) {
+        for(int k = 0; k < 3; k++) {
+            packedScan[k] = ~0ULL;
+            packedHits[k] = 0;
+        }
+    }
+};
+
+
+static void keepBest(unsigned long long& best, unsigned long long time) {
+    if(time < best) best = time;
+}
+
+
+static unsigned int bruteForce(const Level& level) {
+    unsigned int pairs = 0;
+    unsigned int count = level.rects.size();
+
+    for(unsigned int i = 0; i < count; i++) {
+        for(unsigned int j = i + 1; j < count; j++) {
+            if(level.rects[i].overlaps(level.rects[j])) pairs++;
+        }
+    }
+
+    return pairs;
+}
+
+
+static unsigned int rectScan(const Level& level, const std::vector<FlxRect>& areas) {
+    unsigned int hits = 0;
+
+    for(unsigned int a = 0; a < areas.size(); a++) {
+        for(unsigned int i = 0; i < level.rects.size(); i++) {
+            if(areas[a].overlaps(level.rects[i])) hits++;
+        }
+    }
+
+    return hits;
+}
+
+
+static unsigned int packedScan(const FlxBoxes& boxes, const std::vector<FlxRect>& areas, std::vector<unsigned int>& masks) {
+    unsigned int hits = 0;
+
+    for(unsigned int a = 0; a < areas.size(); a++) {
+        FlxBox area = { areas[a].x, areas[a].y, areas[a].x + areas[a].width, areas[a].y + areas[a].height };
+        hits += boxes.query(area, 0, boxes.size(), &masks[0], false);
+    }
+
+    return hits;
+}
+
+
+static void printTime(const char *name, unsigned long long time, bool last = false) {
+    if(time == ~0ULL) printf("      \"%s\": null%s\n", name, last ? "" : ",");
+    else printf("      \"%s\": %llu%s\n", name, time, last ? "" : ",");
+}
+
+
+static void printUsage() {
+    fprintf(stderr, "Usage: FlxBroadphaseBenchmark [--iterations n] [--platforms percent]\n");
+}
+
+
+int main(int argc, char *argv[]) {
+    unsigned int iterations = 10;
+    unsigned int platforms = 2;
+
+    for(int i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--platforms") && i + 1 < argc) platforms = atoi(argv[++i]);
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if(iterations == 0) iterations = 1;
+
+    srand(1);
+
+    printf("{\n");
+    printf("  \"iterations\": %u,\n", iterations);
+    printf("  \"platforms_percent\": %u,\n", platforms);
+    printf("  \"levels\": [");
+
+    for(unsigned int s = 0; s < sizeof(LevelSizes) / sizeof(LevelSizes[0]); s++) {
+        unsigned int count = LevelSizes[s];
+        Level level(count, platforms);
+        Result result;
+
+        FlxSpatialHash hash;
+        FlxQuadTree tree;
+
+        FlxBox bounds = { 0, 0, level.size, level.size };
+        tree.setBounds(bounds, 8);
+
+        for(unsigned int i = 0; i < count; i++) {
+            tree.insert(level.getBox(i));
+        }
+
+        for(unsigned int it = 0; it < iterations; it++) {
+            level.step();
+
+            if(count <= MaxBruteIterationsSize || it == 0) {
+                Clock::time_point start = Clock::now();
+                result.brutePairs = bruteForce(level);
+                keepBest(result.brute, elapsedSince(start));
+            }
+
+            // spatial hash
+            Clock::time_point start = Clock::now();
+            hash.begin(16.f);
+
+            for(unsigned int i = 0; i < count; i++) {
+                hash.insert(level.getBox(i));
+            }
+
+            hash.end();
+            keepBest(result.hashBuild, elapsedSince(start));
+
+            start = Clock::now();
+            unsigned int pairs = 0;
+
+            for(unsigned int i = 0; i < count; i++) {
+                hash.query(hash.getBox(i), [&](unsigned int other) {
+                    if(other > i && level.rects[i].overlaps(level.rects[other])) pairs++;
+                });
+            }
+
+            keepBest(result.hashPairs, elapsedSince(start));
+            result.hashPairsCount = pairs;
+
+            // quadtree
+            start = Clock::now();
+
+            for(unsigned int i = 0; i < count; i++) {
+                tree.move(i, level.getBox(i));
+            }
+
+            keepBest(result.quadtreeMove, elapsedSince(start));
+
+            start = Clock::now();
+            pairs = 0;
+
+            tree.queryPairs([&](unsigned int a, unsigned int b) {
+                if(level.rects[a].overlaps(level.rects[b])) pairs++;
+            });
+
+            keepBest(result.quadtreePairs, elapsedSince(start));
+            result.quadtreePairsCount = pairs;
+
+            // packed kernels against FlxRect::overlaps() loop (areas are the first hitboxes)
+            std::vector<FlxRect> areas(level.rects.begin(), level.rects.begin() + ScanAreas);
+
+            start = Clock::now();
+            result.rectHits = rectScan(level, areas);
+            keepBest(result.rectScan, elapsedSince(start));
+
+            FlxBoxes boxes;
+            boxes.reserve(count);
+
+            for(unsigned int i = 0; i < count; i++) {
+                boxes.add(level.rects[i]);
+            }
+
+            std::vector<unsigned int> masks(FlxBoxes::getMaskWords(count));
+            FlxKinematics::Kernel kernel = FlxKinematics::getKernel();
+
+            for(int k = 0; k < 3; k++) {
+                if(!FlxKinematics::setKernel((FlxKinematics::Kernel) k)) continue;
+
+                start = Clock::now();
+                result.packedHits[k] = packedScan(boxes, areas, masks);
+                keepBest(result.packedScan[k], elapsedSince(start));
+            }
+
+            FlxKinematics::setKernel(kernel);
+        }
+
+        // brute force of big levels ran in the first iteration only
+        if(count > MaxBruteIterationsSize && iterations > 1) {
+            result.brutePairs = bruteForce(level);
+        }
+
+        bool ok = result.brutePairs == result.hashPairsCount && result.brutePairs == result.quadtreePairsCount;
+
+        for(int k = 0; k < 3; k++) {
+            if(FlxKinematics::isSupported((FlxKinematics::Kernel) k) && result.packedHits[k] != result.rectHits) ok = false;
+        }
+
+        printf("%s\n    {\n", s == 0 ? "" : ",");
+        printf("      \"objects\": %u,\n", count);
+        printf("      \"brute_ns\": %llu,\n", result.brute);
+        printf("      \"hash_build_ns\": %llu,\n", result.hashBuild);
+        printf("      \"hash_pairs_ns\": %llu,\n", result.hashPairs);
+        printf("      \"quadtree_move_ns\": %llu,\n", result.quadtreeMove);
+        printf("      \"quadtree_pairs_ns\": %llu,\n", result.quadtreePairs);
+        printf("      \"quadtree_nodes\": %u,\n", tree.getNodesCount());
+        printf("      \"pairs\": %u,\n", result.brutePairs);
+        printTime("rect_scan_ns", result.rectScan);
+        printTime("packed_scalar_ns", result.packedScan[FlxKinematics::SCALAR]);
+        printTime("packed_sse_ns", result.packedScan[FlxKinematics::SSE]);
+        printTime("packed_avx_ns", result.packedScan[FlxKinematics::AVX]);
+        printf("      \"ok\": %s\n", ok ? "true" : "false");
+        printf("    }");
+    }
+
+    printf("\n  ]\n");
+    printf("}\n");
+
+    return 0;
+}
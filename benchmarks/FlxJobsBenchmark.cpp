@@ -0,0 +1,209 @@
+/*
+   This file is a part of "Flixel C++ port" project
+   Copyrights (c) by Michał Korman 2012
+*/
+
+/*
+*  Jobs system microbenchmark.
+*  Compares serial loops with FlxG::jobs.parallelFor on groups of 1k, 10k and 100k objects
+*  and measures cost of single jobs (add + wait, dependencies chain). Results are printed
+*  as JSON. It doesn't open any window, so no backend is needed.
+*
+*  Build it together with core sources (src/ and src/tweener/). Example for GCC:
+*     g++ -std=gnu++0x -O2 -pthread -DFLX_NO_SCRIPT -Iinclude -Isrc benchmarks/FlxJobsBenchmark.cpp <sources> -o FlxJobsBenchmark
+*
+*  Usage:
+*     FlxJobsBenchmark [--workers n] [--iterations n] [--grain n]
+*
+*  Reported values (best of all iterations, in nanoseconds):
+*     - serial_ns / parallel_ns - time of one pass over the whole group
+*     - speedup                 - serial_ns / parallel_ns
+*/
+#include <FlxG.h>
+#include <FlxObject.h>
+#include <FlxGroup.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static unsigned long long elapsedSince(const Clock::time_point& start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+}
+
+
+/*
+*  Per-object work
+*/
+static void updateLight(FlxBasic *basic) {
+    basic->update();
+}
+
+
+// update + some AI-like math (distance to few targets)
+static void updateHeavy(FlxBasic *basic) {
+    FlxObject *obj = (FlxObject*) basic;
+    obj->update();
+
+    float best = 1e30f;
+    for(int i = 0; i < 32; i++) {
+        float dx = obj->x - i * 40.f;
+        float dy = obj->y - (i & 7) * 60.f;
+        float dist = std::sqrt(dx * dx + dy * dy);
+
+        if(dist < best) best = dist;
+    }
+
+    obj->angle = best * 0.01f;
+}
+
+
+struct Workload {
+    const char *name;
+    void (*update)(FlxBasic *basic);
+};
+
+static const Workload Workloads[] = {
+    { "update", updateLight },
+    { "update_heavy", updateHeavy }
+};
+
+static const unsigned int GroupSizes[] = { 1000, 10000, 100000 };
+
+
+static void fillGroup(FlxGroup& group, unsigned int count) {
+    for(unsigned int i = 0; i < count; i++) {
+        FlxObject *obj = new FlxObject();
+        obj->x = (float)(rand() % 1000);
+        obj->y = (float)(rand() % 1000);
+        obj->velocity.x = (float)(rand() % 200 - 100);
+        obj->velocity.y = (float)(rand() % 200 - 100);
+        obj->acceleration.y = 50.f;
+
+        group.add(obj);
+    }
+}
+
+
+static unsigned long long runSerial(FlxGroup& group, const Workload& workload) {
+    Clock::time_point start = Clock::now();
+
+    for(unsigned int i = 0; i < group.members.size(); i++) {
+        workload.update(group.members[i]);
+    }
+
+    return elapsedSince(start);
+}
+
+
+static unsigned long long runParallel(FlxGroup& group, const Workload& workload, unsigned int grain) {
+    Clock::time_point start = Clock::now();
+
+    FlxG::jobs.parallelFor(0, group.members.size(), [&](unsigned int begin, unsigned int end) {
+        for(unsigned int i = begin; i < end; i++) {
+            workload.update(group.members[i]);
+        }
+    }, grain);
+
+    return elapsedSince(start);
+}
+
+
+static void printUsage() {
+    fprintf(stderr, "Usage: FlxJobsBenchmark [--workers n] [--iterations n] [--grain n]\n");
+}
+
+
+int main(int argc, char *argv[]) {
+    int workers = -1;
+    unsigned int iterations = 50;
+    unsigned int grain = 0;
+
+    for(int i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "--workers") && i + 1 < argc) workers = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "--grain") && i + 1 < argc) grain = atoi(argv[++i]);
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    if(iterations == 0) iterations = 1;
+
+    srand(1);
+    FlxG::fixedTime = 1.f / 60.f;
+    FlxG::jobs.init(workers);
+
+    printf("{\n");
+    printf("  \"workers\": %u,\n", FlxG::jobs.getWorkersCount());
+    printf("  \"iterations\": %u,\n", iterations);
+    printf("  \"workloads\": [");
+
+    bool first = true;
+
+    for(unsigned int w = 0; w < sizeof(Workloads) / sizeof(Workloads[0]); w++) {
+        for(unsigned int s = 0; s < sizeof(GroupSizes) / sizeof(GroupSizes[0]); s++) {
+            FlxGroup group;
+            fillGroup(group, GroupSizes[s]);
+
+            unsigned long long serial = ~0ULL, parallel = ~0ULL;
+
+            // warm up caches and threads
+            runSerial(group, Workloads[w]);
+            runParallel(group, Workloads[w], grain);
+
+            for(unsigned int i = 0; i < iterations; i++) {
+                unsigned long long t = runSerial(group, Workloads[w]);
+                if(t < serial) serial = t;
+
+                t = runParallel(group, Workloads[w], grain);
+                if(t < parallel) parallel = t;
+            }
+
+            printf("%s\n    {\n", first ? "" : ",");
+            printf("      \"name\": \"%s\",\n", Workloads[w].name);
+            printf("      \"objects\": %u,\n", GroupSizes[s]);
+            printf("      \"serial_ns\": %llu,\n", serial);
+            printf("      \"parallel_ns\": %llu,\n", parallel);
+            printf("      \"speedup\": %.2f\n", parallel ? (double)serial / parallel : 0.0);
+            printf("    }");
+            first = false;
+        }
+    }
+
+    printf("\n  ],\n");
+
+    // cost of single empty job
+    const unsigned int jobsCount = 10000;
+    Clock::time_point start = Clock::now();
+
+    for(unsigned int i = 0; i < jobsCount; i++) {
+        FlxG::jobs.wait(FlxG::jobs.add([]() { }));
+    }
+
+    unsigned long long addWait = elapsedSince(start) / jobsCount;
+
+    // chain of dependent jobs
+    std::atomic<unsigned int> counter(0);
+    FlxJobHandle last;
+    start = Clock::now();
+
+    for(unsigned int i = 0; i < jobsCount; i++) {
+        last = FlxG::jobs.add([&counter]() { counter++; }, last);
+    }
+
+    FlxG::jobs.wait(last);
+    unsigned long long chain = elapsedSince(start) / jobsCount;
+
+    printf("  \"job_add_wait_ns\": %llu,\n", addWait);
+    printf("  \"job_chain_ns\": %llu,\n", chain);
+    printf("  \"job_chain_ok\": %s\n", counter == jobsCount ? "true" : "false");
+    printf("}\n");
+
+    FlxG::jobs.shutdown();
+    return 0;
+}
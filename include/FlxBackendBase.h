@@ -19,6 +19,7 @@
 class FlxBackendImage {
 
 public:
+    virtual ~FlxBackendImage() { }
     virtual int getWidth() = 0;
     virtual int getHeight() = 0;
     virtual int getFormat() = 0;
@@ -40,13 +41,14 @@ public:
 };
 
 /*
-*  Template for sound
+*  Template for sound voice (reusable player of sounds returned by loadSound)
 */
 class FlxBackendSound {
 
 public:
     virtual ~FlxBackendSound() { }
 
+    virtual void setSound(void *sound) = 0;
     virtual void play() = 0;
     virtual void stop() = 0;
 
@@ -83,6 +85,12 @@ struct FlxBaseText {
     void *data, *font;
 };
 
+// Single sprite of batched draw call (see drawImages)
+struct FlxBatchSprite {
+    float x, y, angle;
+    FlxRect source;
+};
+
 
 // Filesystem access interface
 class FlxBackendFile {
@@ -108,11 +116,12 @@ public:
 class FlxBackendBase {
 
 public:
+    virtual ~FlxBackendBase() { }
     virtual std::string getName() = 0;
 
     // app managment and input
     virtual bool setupSurface(const char *title, int width, int height, const char *icon) = 0;
-    virtual void mainLoop(void (*onUpdate)(), void (*onDraw)()) = 0;
+    virtual void mainLoop(void (*onUpdate)(), void (*onDraw)());
     virtual FlxVector getScreenSize() = 0;
     virtual void exitApplication() = 0;
     virtual bool* getKeysDown() = 0;
@@ -125,6 +134,10 @@ public:
     virtual void drawImage(FlxBackendImage *img, float x, float y, const FlxVector& scale, float angle,
                         const FlxRect& source, int color, bool flipped, float alpha) = 0;
 
+    // many sprites of the same image, scale, color and alpha (default: drawImage for every sprite)
+    virtual void drawImages(FlxBackendImage *img, const FlxBatchSprite *sprites, unsigned int count,
+                            const FlxVector& scale, int color, float alpha);
+
     // text rendering
     virtual FlxBaseText *createText(const wchar_t *text, void *font, int size, int color, float alpha) = 0;
     virtual void destroyText(FlxBaseText *data) = 0;
@@ -136,16 +149,22 @@ public:
     virtual FlxBackendShader* loadShader(const char *path) = 0;
     virtual void drawShader(FlxBackendShader *shader) = 0;
 
+    // can draw calls, beginDraw() and endDraw() be called from render thread? (see FlxRenderer)
+    virtual bool isRenderThreadSupported() { return false; }
+
     // image loading
     virtual FlxBackendImage* createImage(int width, int height, int color, float alpha) = 0;
     virtual FlxBackendImage *loadImage(const char *path) = 0;
 
+    // can assets be loaded from worker thread? (see FlxG::switchStateAsync)
+    virtual bool isAsyncLoadingSupported() { return false; }
+
     // text loading
     virtual void *loadFont(const char *path, int fontSize) = 0;
 
     // audio
     virtual void* loadSound(const char *path) = 0;
-    virtual FlxBackendSound* playSound(void *sound, float vol) = 0;
+    virtual FlxBackendSound* createSound() = 0;
     virtual FlxBackendMusic* loadMusic(const char *path) = 0;
     virtual void playMusic(FlxBackendMusic *music, float vol) = 0;
 
@@ -154,6 +173,14 @@ public:
 
     // network
     virtual bool sendHttpRequest(FlxHttpRequest *req, FlxHttpResponse& resp) = 0;
+
+    // main loop hooks (used by default fixed timestep mainLoop)
+    virtual bool isRunning() { return true; }
+    virtual double getTime();
+    virtual void beginFrame() { }
+    virtual void updateEvents() { }
+    virtual void beginDraw() { }
+    virtual void endDraw() { }
 };
 
 #endif
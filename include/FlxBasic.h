@@ -7,6 +7,7 @@
 
 #include "backend/cpp.h"
 #include "FlxVector.h"
+#include "FlxHandles.h"
 
 /**
 *  Represents type of entity (single object or group of objects)
@@ -26,7 +27,8 @@ class FlxBasic {
 public:
 
     /**
-    *  Collision callback type. Used in <code>overlaps()</code> and <code>collide()</code>
+    *  Collision callback type. Used in <code>overlaps()</code> and <code>collide()</code>.
+    *  Pointers are valid only during the call, keep <code>handle</code>s of entities for later.
     */
     typedef std::function<void(FlxBasic*, FlxBasic*)> CollisionCallback;
 
@@ -41,6 +43,33 @@ public:
     */
     bool active;
 
+    /**
+    *  Is entity alive? <code>kill()</code> marks entity as dead, so it can be reused by
+    *  <code>FlxGroup::recycle()</code>. Dead entities don't collide.
+    */
+    bool alive;
+
+    /**
+    *  Pool which entity belongs to (Internal! Do not touch!)
+    */
+    const void *poolKey;
+
+    /**
+    *  Position in parent group's members (Internal! Do not touch!)
+    */
+    unsigned int memberIndex;
+
+    /**
+    *  Is entity put to sleep by its group? Sleeping entities aren't updated, but they are
+    *  still drawn and collide (see <code>FlxGroup::sleep()</code>). Read-only.
+    */
+    bool sleeping;
+
+    /**
+    *  Position in parent group's list of awake members (Internal! Do not touch!)
+    */
+    unsigned int awakeIndex;
+
     /**
     *  Should entity be moved by scroolVector
     */
@@ -56,21 +85,54 @@ public:
     */
     int flags;
 
+    /**
+    *  Generational handle of entity. Keep it instead of pointer when entity may be destroyed
+    *  meanwhile (see <code>FlxHandles</code>).
+    */
+    FlxHandle handle;
+
 
     /**
     *  Default constructor
     */
     FlxBasic() {
         active = true;
+        alive = true;
+        poolKey = NULL;
+        memberIndex = 0;
+        sleeping = false;
+        awakeIndex = 0;
         scrool = true;
         scroolFactor.x = scroolFactor.y = 1.f;
         flags = 0;
+        handle = FlxHandles::create(this);
+    }
+
+    /**
+    *  Copy constructor (copy is a new entity with its own handle, outside of any group)
+    */
+    FlxBasic(const FlxBasic& other) {
+        copyFrom(other);
+        poolKey = NULL;
+        memberIndex = 0;
+        sleeping = false;
+        awakeIndex = 0;
+        handle = FlxHandles::create(this);
+    }
+
+    /**
+    *  Assignment operator (keeps handle and group bookkeeping)
+    */
+    FlxBasic& operator=(const FlxBasic& other) {
+        if(this != &other) copyFrom(other);
+        return *this;
     }
 
     /**
     *  Destructior's template
     */
     virtual ~FlxBasic() {
+        FlxHandles::destroy(handle);
     }
 
     /**
@@ -88,10 +150,19 @@ public:
     }
 
     /**
-    *  Deactivate entity
+    *  Deactivate entity and mark it as dead
     */
     virtual void kill() {
         active = false;
+        alive = false;
+    }
+
+    /**
+    *  Bring dead entity back to life
+    */
+    virtual void revive() {
+        active = true;
+        alive = true;
     }
 
     /**
@@ -118,6 +189,16 @@ public:
         (void)object; (void)callback;
         return NULL;
     }
+
+private:
+    void copyFrom(const FlxBasic& other) {
+        entityType = other.entityType;
+        active = other.active;
+        alive = other.alive;
+        scrool = other.scrool;
+        scroolFactor = other.scroolFactor;
+        flags = other.flags;
+    }
 };
 
 #endif
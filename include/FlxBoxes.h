@@ -0,0 +1,161 @@
+/*
+   This file is a part of "Flixel C++ port" project
+   Copyrights (c) by Michał Korman 2012
+*/
+#ifndef _FLX_BOXES_H_
+#define _FLX_BOXES_H_
+
+#include "backend/cpp.h"
+#include "FlxRect.h"
+
+
+/**
+*  Packed boxes for batched overlap tests.<br />
+*  Corners are kept in separate float arrays (structure of arrays, aligned to 32 bytes and padded
+*  to 8 elements), so one box is tested against 4 or 8 others at once. Results are bit masks:
+*  bit <code>j</code> of word <code>w</code> is set when box <code>w * 32 + j</code> overlaps.
+*  Kernel (scalar, SSE or AVX) is the one selected by <code>FlxKinematics::getKernel()</code>.
+*  Queries don't change anything, so they can run on many threads at once.
+*/
+class FlxBoxes {
+
+    float *storage;
+    float *minX, *minY, *maxX, *maxY;
+    unsigned int count, capacity;
+
+    // not copyable
+    FlxBoxes(const FlxBoxes&);
+    FlxBoxes& operator=(const FlxBoxes&);
+public:
+
+    /**
+    *  Count of boxes checked by one <code>query()</code> block of the visiting version
+    */
+    static const unsigned int BlockSize = 256;
+
+    /**
+    *  Default constructor
+    */
+    FlxBoxes();
+
+    /**
+    *  Destructor
+    */
+    ~FlxBoxes();
+
+    /**
+    *  Remove all boxes (memory is kept)
+    */
+    void clear();
+
+    /**
+    *  Reserve memory
+    *  @param boxes Count of boxes
+    */
+    void reserve(unsigned int boxes);
+
+    /**
+    *  Add box. Boxes are numbered in order of adding, starting from 0.
+    *  @param box Box to add
+    *  @return Id of box
+    */
+    unsigned int add(const FlxBox& box);
+
+    /**
+    *  Add hitbox (the same edges as in <code>FlxRect::overlaps()</code>)
+    *  @param rect Hitbox to add
+    *  @return Id of box
+    */
+    unsigned int add(const FlxRect& rect) {
+        FlxBox box = { rect.x, rect.y, rect.x + rect.width, rect.y + rect.height };
+        return add(box);
+    }
+
+    /**
+    *  Change box
+    *  @param id Id of box
+    *  @param box New box
+    */
+    void set(unsigned int id, const FlxBox& box) {
+        minX[id] = box.minX;
+        minY[id] = box.minY;
+        maxX[id] = box.maxX;
+        maxY[id] = box.maxY;
+    }
+
+    /**
+    *  Get box
+    *  @param id Id of box
+    *  @return Box
+    */
+    FlxBox getBox(unsigned int id) const {
+        FlxBox box = { minX[id], minY[id], maxX[id], maxY[id] };
+        return box;
+    }
+
+    /**
+    *  Get count of boxes
+    *  @return Boxes count
+    */
+    unsigned int size() const {
+        return count;
+    }
+
+    /**
+    *  Get count of mask words needed for boxes
+    *  @param boxes Count of boxes
+    *  @return Count of 32-bit words
+    */
+    static unsigned int getMaskWords(unsigned int boxes) {
+        return (boxes + 31) / 32;
+    }
+
+    /**
+    *  Test area against range of boxes
+    *  @param area Area to check
+    *  @param first Id of the first box (multiple of 8)
+    *  @param boxes Count of boxes to check
+    *  @param masks Results (<code>getMaskWords(boxes)</code> words, bit 0 is box <code>first</code>)
+    *  @param touching <code>true</code> if touching edges count as overlap (like <code>FlxBox</code>),
+    *                  <code>false</code> for the same result as <code>FlxRect::overlaps()</code>
+    *  @return Count of overlapping boxes
+    */
+    unsigned int query(const FlxBox& area, unsigned int first, unsigned int boxes, unsigned int *masks,
+                       bool touching = true) const;
+
+    /**
+    *  Test every box of <code>areas</code> against all boxes (e.g. objects of one broadphase cell
+    *  against objects of other one)
+    *  @param areas Boxes to check
+    *  @param masks Results, one row of <code>getMaskWords(size())</code> words per box of <code>areas</code>
+    *  @param touching See <code>query()</code>
+    *  @return Count of overlapping pairs
+    */
+    unsigned int query(const FlxBoxes& areas, unsigned int *masks, bool touching = true) const;
+
+    /**
+    *  Call function for every box which overlaps area
+    *  @param area Area to check
+    *  @param visit Function called with id of every found box (in order of ids)
+    *  @param touching See <code>query()</code>
+    */
+    template<class F> void query(const FlxBox& area, F visit, bool touching = true) const {
+        unsigned int masks[BlockSize / 32];
+
+        for(unsigned int first = 0; first < count; first += BlockSize) {
+            unsigned int boxes = (count - first < BlockSize) ? count - first : BlockSize;
+            if(query(area, first, boxes, masks, touching) == 0) continue;
+
+            for(unsigned int w = 0; w < getMaskWords(boxes); w++) {
+                for(unsigned int bits = masks[w]; bits != 0; bits &= bits - 1) {
+                    unsigned int bit = 0;
+                    while(!(bits & (1u << bit))) bit++;
+
+                    visit(first + w * 32 + bit);
+                }
+            }
+        }
+    }
+};
+
+#endif
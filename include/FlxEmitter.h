@@ -18,6 +18,23 @@ class FlxEmitter : public FlxGroup {
 
 private:
     std::string tileset;
+
+    // batched particles (structure of arrays, slots are reused as a ring)
+    std::vector<float> particleX, particleY;
+    std::vector<float> particleVelocityX, particleVelocityY;
+    std::vector<float> particleLife, particleAngle;
+    std::vector<unsigned short> particleFrame;
+    unsigned int capacity, usedSlots, nextSlot, liveParticles;
+    unsigned int lastBatchUpdate;
+
+    FlxBackendImage *graphic;
+    std::vector<FlxRect> frames;
+    std::vector<FlxBatchSprite> batch;
+
+    void emitBatched(int howMany);
+    void updateBatched();
+    void drawBatched();
+    void loadFrames();
 public:
 
 	/**
@@ -122,6 +139,26 @@ public:
 	*/
     void emit(int howMany);
 
+    /**
+	*  Switch to batched particles. Particles aren't <code>FlxParticle</code> objects anymore (and
+	*  insertion callback isn't called), they are kept in plain arrays, moved by SIMD code and drawn
+	*  by single draw call. When all slots are used, the oldest particles are replaced.
+	*  @param maxParticles Maximum count of live particles (0 = go back to <code>FlxParticle</code> objects)
+	*/
+    void setBatched(unsigned int maxParticles);
+
+    /**
+	*  Are particles batched?
+	*  @return <code>true</code> if <code>setBatched()</code> was called with non-zero capacity
+	*/
+    bool isBatched();
+
+    /**
+	*  Get count of live particles
+	*  @return Particles count
+	*/
+    unsigned int getParticlesCount();
+
 	/**
 	*  Overrided update event
 	*/
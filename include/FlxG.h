@@ -26,6 +26,10 @@
 #include "FlxVirtualKeyboard.h"
 #include "FlxPath.h"
 #include "FlxScript.h"
+#include "FlxProfiler.h"
+#include "FlxTimestep.h"
+#include "FlxJobs.h"
+#include "FlxRenderer.h"
 
 #include "tweener/CppTween.h"
 
@@ -67,6 +71,39 @@ public:
 	*/
     static float fixedTime;
 
+    /**
+	*  Main loop timestep settings (updates limit per frame, catch up policy, dropped time counters)
+	*/
+    static FlxTimestep timestep;
+
+    /**
+	*  Jobs system (started by <code>setup()</code>, call <code>jobs.init()</code> before to
+	*  choose count of workers)
+	*/
+    static FlxJobs jobs;
+
+    /**
+	*  Draw calls dispatcher. Use <code>renderer.setPipelined(true)</code> to record draw calls
+	*  and render previous frame on render thread, while current one is updated.
+	*/
+    static FlxRenderer renderer;
+
+    /**
+	*  Interpolate drawn objects between two last fixed updates. Makes motion smooth when
+	*  <code>fixedTime</code> is longer than frame. Default: <code>false</code>
+	*/
+    static bool interpolation;
+
+    /**
+	*  Part of fixed update passed since last update (0 - 1), set by main loop before drawing
+	*/
+    static float interpolationAlpha;
+
+    /**
+	*  Count of fixed updates since application start
+	*/
+    static unsigned int updatesCount;
+
     /**
 	*  Total time of application existance (in seconds)
 	*/
@@ -82,6 +119,17 @@ public:
 	*/
     static float fps;
 
+    /**
+	*  Time spent on assets warm-up in single update during <code>switchStateAsync()</code>
+	*  (in seconds). At least one asset is loaded every update. Default: 0.005
+	*/
+    static float loadingBudget;
+
+    /**
+	*  Time between last <code>switchStateAsync()</code> call and states swap (in seconds)
+	*/
+    static float lastSwitchTime;
+
     /**
 	*  Framework backend
 	*/
@@ -159,8 +207,8 @@ public:
 
 
     /**
-	*  Follow some object with camera
-	*  @param object Object to follow
+	*  Follow some object with camera. Camera stops following when object is destroyed.
+	*  @param object Object to follow (<code>NULL</code> to stop following)
 	*/
     static void followObject(FlxObject *object);
 
@@ -198,6 +246,22 @@ public:
 	*/
     static void switchState(FlxState *newState);
 
+    /**
+	*  Switch state without blocking the game. Current state (or <code>transition</code> state)
+	*  keeps running while assets of new state are warmed up (see <code>FlxState::preloadImage()</code>)
+	*  and <code>FlxState::load()</code> runs on worker thread. States are swapped when new state
+	*  is ready (<code>FlxState::isReady()</code>). Time to swap is logged.
+	*  @param newState State to switch
+	*  @param transition State shown during loading (<code>NULL</code> = keep current one)
+	*/
+    static void switchStateAsync(FlxState *newState, FlxState *transition = NULL);
+
+    /**
+	*  Is any state being loaded by <code>switchStateAsync()</code>?
+	*  @return <code>true</code> if states aren't swapped yet
+	*/
+    static bool isLoadingState();
+
     /**
 	*  Update touch devices (Internal. Do not touch!)
 	*/
@@ -244,7 +308,7 @@ public:
 private:
 
     // object to follow
-    static FlxObject *toFollow;
+    static FlxHandle toFollow;
 
     // fps stuff
     static float fpsCounter;
@@ -252,8 +316,20 @@ private:
     // state to switch next frame
     static FlxState *stateToSwitch;
 
+    // state loaded in background
+    static FlxState *stateToLoad;
+    static FlxJobHandle stateLoadJob;
+    static bool stateLoadStarted;
+    static unsigned long long switchRequestTime;
+
+    static void swapState(FlxState *newState);
+    static bool warmUpState(FlxState *loading);
+    static void updateLoading();
+    static void cancelLoading();
+
     // flash screen effect stuff
     static FlxSprite flashSprite;
+    static FlxVector lastScroolVector;
     static float flashCounter, flashMaxTime;
 };
 
@@ -7,23 +7,265 @@
 
 #include "backend/cpp.h"
 #include "FlxBasic.h"
+#include "FlxRect.h"
+#include "FlxSpatialHash.h"
+#include "FlxQuadTree.h"
+#include "FlxBoxes.h"
 
 
 class FlxObject;
 
 
+/**
+*  How removed members are squeezed out of group (see <code>FlxGroup::compact()</code>)
+*/
+enum FlxCompactionMode {
+    FLX_COMPACT_STABLE,     // keep order of members (draw order)
+    FLX_COMPACT_SWAP        // move the last members into holes (faster, order changes)
+};
+
+
+/**
+*  Draw order of group's members (see <code>FlxGroup::sortMode</code>)
+*/
+enum FlxSortMode {
+    FLX_SORT_NONE,          // order of adding
+    FLX_SORT_Z,             // by FlxObject::z
+    FLX_SORT_Y,             // by bottom edge (y + height), for top-down games
+    FLX_SORT_CUSTOM         // by FlxGroup::sortKey
+};
+
+
+/**
+*  Structure used to find members near other objects (see <code>FlxGroup::broadphaseMode</code>)
+*/
+enum FlxBroadphaseMode {
+    FLX_BROADPHASE_HASH,        // uniform grid, best for objects of similar sizes
+    FLX_BROADPHASE_QUADTREE     // loose quadtree, for mixed sizes (huge platforms and tiny bullets)
+};
+
+
 /**
 *  Collection of game entities (objects or other groups)
 */
 class FlxGroup : public FlxBasic {
 
+private:
+    struct PendingChange {
+        enum Type { ADD, REMOVE, KILL, SLEEP, WAKE } type;
+        FlxBasic *object;
+        bool dontDelete;
+    };
+
+    std::vector<PendingChange> pendingChanges;
+
+    void defer(PendingChange::Type type, FlxBasic *object, bool dontDelete = false);
+    static void applyPendingChanges();
+
+    // recycled members of single type
+    struct Pool {
+        std::vector<FlxBasic*> objects;
+        unsigned int next;
+        unsigned int maxSize;
+
+        Pool() : next(0), maxSize(0) { }
+    };
+
+    std::map<const void*, Pool> pools;
+
+    template<class T> static const void* getPoolKey() {
+        static char key;
+        return &key;
+    }
+
+    FlxBasic* reuse(const void *key);
+    void addToPool(const void *key, FlxBasic *object);
+    void removeFromPool(FlxBasic *object);
+
+    void updateMembers(std::vector<FlxBasic*>& list, unsigned int begin, unsigned int end);
+
+    // removed members waiting for compaction
+    std::vector<FlxBasic*> removedMembers;
+    unsigned int holes;
+    unsigned int version;
+
+    // members of whole subtree flattened into draw order (rebuilt when any version changes)
+    struct DrawCache {
+        std::vector<FlxBasic*> world;
+        std::vector<FlxBasic*> gui;
+        std::vector<std::pair<FlxGroup*, unsigned int> > groups;
+        unsigned int version;
+        bool valid;
+
+        DrawCache() : version(0), valid(false) { }
+    };
+
+    DrawCache drawCache;
+
+    // flat groups draw members directly, they are the flattened list already
+    unsigned int subgroupsCount;
+
+    bool isDrawCacheValid();
+    void rebuildDrawCache();
+    void flattenMembers(FlxGroup *group);
+
+    // members sorted by sortMode (reused every frame)
+    struct SortEntry {
+        float key;
+        size_t texture;
+        unsigned int order;
+        FlxBasic *member;
+    };
+
+    std::vector<SortEntry> sortEntries, sortScratch;
+    std::vector<unsigned long long> radixKeys, radixScratch;
+
+    float getSortKey(FlxBasic *member);
+    bool insertionSort(unsigned int maxMoves);
+    void radixSort();
+
+    // sleeping members sorted by x of their centers (new ones are merged in batches), so wake
+    // queries are binary searches and never touch other sleepers
+    struct Sleeper {
+        float x, y;
+        FlxBasic *member;
+    };
+
+    std::vector<Sleeper> sleepers, newSleepers, sleepersScratch;
+    unsigned int sleepersHoles;
+    unsigned int asleepCount;
+
+    // members updated instead of whole members list while some are asleep
+    std::vector<FlxBasic*> awake;
+    unsigned int awakeHoles;
+    bool partitioned;
+
+    int awakeIndexOf(FlxBasic *member);
+    void addAwake(FlxBasic *member);
+    void removeAwake(FlxBasic *member);
+    void removeSleeper(FlxBasic *member);
+    void mergeSleepers();
+    FlxRect getWakeArea();
+    void sleepDistantMembers();
+
+    // object members (hitboxes swept by velocity) in spatial hash or quadtree (or packed boxes
+    // scanned by SIMD kernels in groups below threshold), refreshed once per fixed step and rebuilt
+    // when members change. Swept boxes still cover members which keep moving in this step, members
+    // reset or revived somewhere else are found from the next step.
+    FlxSpatialHash spatialHash;
+    FlxQuadTree quadTree;
+    FlxBoxes packedBoxes;
+    FlxBroadphaseMode builtMode;
+    bool builtPacked;
+    std::vector<FlxBox> broadphaseBoxes;
+    std::vector<FlxBasic*> broadphaseMembers;
+    std::vector<unsigned int> broadphaseIndices;
+    std::vector<unsigned int> broadphaseGroups;
+    unsigned int broadphaseVersion;
+    unsigned int broadphaseStep;
+    bool broadphaseValid;
+
+    // table isn't rebuilt while it's iterated (collision callbacks may check collisions too)
+    unsigned int broadphaseQueries;
+
+    void rebuildBroadphase();
+
+    // object members sorted by their boxes along the axis with bigger spread (used by selfOverlaps
+    // and selfCollide). Order is kept between calls, so members moving a little are sorted again
+    // by insertion sort in almost linear time.
+    struct SweepEntry {
+        float min, max;
+        FlxBox box;
+        FlxBasic *member;
+    };
+
+    std::vector<SweepEntry> sweepEntries;
+    std::vector<FlxBasic*> sweepGroups;
+    unsigned int sweepVersion;
+    int sweepAxis;
+    bool sweeping;
+
+    template<class F> void sweepPairs(bool swept, F visit);
+protected:
+
+    // position of member in members (-1 if it isn't a member)
+    int indexOf(FlxBasic *object);
 public:
 
     /**
-	*  Members of group
+	*  Members of group. Removed members leave <code>NULL</code> holes until the next
+	*  <code>compact()</code>, so always check for <code>NULL</code> here.
 	*/
     std::vector<FlxBasic*> members;
 
+    /**
+	*  How holes are removed from <code>members</code>. Default: <code>FLX_COMPACT_STABLE</code>
+	*/
+    FlxCompactionMode compactionMode;
+
+    /**
+	*  Members are thread-safe (e.g. plain FlxObject/FlxSprite movers), so they can be updated
+	*  in parallel by <code>FlxG::jobs</code>. <code>add()</code>, <code>remove()</code> and
+	*  <code>killMember()</code> called by members during parallel update (on any group) are deferred
+	*  until all members are updated. Default: <code>false</code>
+	*/
+    bool parallelUpdate;
+
+    /**
+	*  Minimum count of members updated by single job. Smaller groups are updated serially.
+	*  Default: 256
+	*/
+    unsigned int parallelGrain;
+
+    /**
+	*  Members of this group are drawn straight from parent's flattened draw list, so its own
+	*  <code>draw()</code> and <code>drawGUI()</code> aren't called at all. Turn it on only for plain
+	*  containers (layers of sprites), never for subclasses which override <code>draw()</code> or
+	*  <code>drawGUI()</code>. Default: <code>false</code>
+	*/
+    bool flattenDraw;
+
+    /**
+	*  Order of members kept by <code>sort()</code> (called at the end of every <code>update()</code>).
+	*  Members with equal keys are grouped by texture (see <code>FlxObject::getTextureKey()</code>).
+	*  Subgroups have key 0. Default: <code>FLX_SORT_NONE</code>
+	*/
+    FlxSortMode sortMode;
+
+    /**
+	*  Key of member for <code>FLX_SORT_CUSTOM</code> mode (lower keys are drawn first)
+	*/
+    std::function<float(FlxBasic*)> sortKey;
+
+    /**
+	*  Members farther than this from camera's view are put to sleep at the end of <code>update()</code>
+	*  and woken at its beginning when camera comes closer (distance is measured from centers of
+	*  objects to edges of screen, subgroups are never put to sleep). 0 turns it off. Default: 0
+	*/
+    float sleepDistance;
+
+    /**
+	*  Groups with at least this count of members check collisions through spatial hash or quadtree
+	*  of their members (see <code>broadphaseMode</code>), so cost depends on count of nearby pairs
+	*  instead of count of all pairs. Smaller groups test packed hitboxes of all members at once
+	*  (see <code>FlxBoxes</code>). Collisions checked during parallel update use plain loops.
+	*  0 turns it off. Default: 32
+	*/
+    unsigned int broadphaseThreshold;
+
+    /**
+	*  Broadphase used when group is big enough. Boxes of members are refreshed by the first query
+	*  of every step: spatial hash is rebuilt when members moved, quadtree moves only boxes which
+	*  left their nodes. Default: <code>FLX_BROADPHASE_HASH</code>
+	*/
+    FlxBroadphaseMode broadphaseMode;
+
+    /**
+	*  Cell size of spatial hash. 0 means twice the average size of member (with its motion
+	*  in one step). Default: 0
+	*/
+    float broadphaseCellSize;
+
 	/**
 	*  Pair of two entities. Used in <code>selfOverlaps</code> and <code>selfCollide</code> 
 	*/
@@ -44,31 +286,193 @@ public:
     virtual ~FlxGroup();
 
     /**
-	*  Add new entity to group.
+	*  Add new entity to group. During parallel update entity is added after all members are updated.
 	*  @param object Entity to add (musn't be NULL)
 	*  @return <code>object</code> for chaining
 	*/
     FlxBasic* add(FlxBasic *object);
 
     /**
-	*  Remove entity from group and <code>delete</code> it
+	*  Remove entity from group and <code>delete</code> it. Entity's slot is cleared immediately
+	*  (so it's safe to call during iteration), but entity is deleted by the next <code>compact()</code>.
+	*  During parallel update entity is removed after all members are updated.
 	*  @param object Entity to remove
 	*  @param dontDelete Put <code>true</code> here if you wouldn't delete object after removement
 	*  @return <code>true</code> if removement was successful. <code>false</code> if entity was not found in group
 	*/
     bool remove(FlxBasic *object, bool dontDelete = false);
 
+    /**
+	*  Get dead member of type <code>T</code> (created by previous <code>recycle()</code> calls) and
+	*  revive it. If there is no dead member, new one is created and added to group. When pool of
+	*  <code>T</code> is full (see <code>setMaxPoolSize()</code>) the oldest member is reused.
+	*  NOTE: Don't call it during parallel update.
+	*  @return Alive member (reset its position, velocity etc.)
+	*/
+    template<class T> T* recycle() {
+        FlxBasic *object = reuse(getPoolKey<T>());
+        if(object) return static_cast<T*>(object);
+
+        T *created = new T();
+        addToPool(getPoolKey<T>(), created);
+        return created;
+    }
+
+    /**
+	*  Same as <code>recycle()</code>, but new members are created by <code>factory</code>
+	*  @param factory Function which creates new member
+	*  @return Alive member
+	*/
+    template<class T> T* recycle(const std::function<T*()>& factory) {
+        FlxBasic *object = reuse(getPoolKey<T>());
+        if(object) return static_cast<T*>(object);
+
+        T *created = factory();
+        if(created) addToPool(getPoolKey<T>(), created);
+        return created;
+    }
+
+    /**
+	*  Set maximum count of recycled members of type <code>T</code>
+	*  @param size Maximum pool size (0 = no limit)
+	*/
+    template<class T> void setMaxPoolSize(unsigned int size) {
+        pools[getPoolKey<T>()].maxSize = size;
+    }
+
+    /**
+	*  Get count of members created by <code>recycle()</code> with type <code>T</code>
+	*  @return Pool size
+	*/
+    template<class T> unsigned int getPoolSize() {
+        std::map<const void*, Pool>::iterator it = pools.find(getPoolKey<T>());
+        return (it != pools.end()) ? it->second.objects.size() : 0;
+    }
+
+    /**
+	*  Kill entity (see <code>FlxBasic::kill()</code>). During parallel update entity is killed
+	*  after all members are updated, so members can safely kill each other.
+	*  @param object Entity to kill
+	*/
+    void killMember(FlxBasic *object);
+
     /**
 	*  Remove all enitites from group and delete it's memory
 	*/
     void clear();
 
     /**
-	*  Get members count
+	*  Get members count (without removed ones)
 	*  @return Elements count
 	*/
     unsigned int size();
 
+    /**
+	*  Squeeze holes left by removed members out of <code>members</code> and delete removed
+	*  members. Called automatically at the beginning of <code>update()</code>.
+	*/
+    void compact();
+
+    /**
+	*  Get membership version. It's changed every time members are added, removed or reordered,
+	*  so it can be used to invalidate data cached per group.
+	*  @return Version counter
+	*/
+    unsigned int getVersion();
+
+    /**
+	*  Sort members by <code>sortMode</code>. Order from previous frame is nearly sorted already,
+	*  so usually it's a short insertion sort. Shuffled groups are radix sorted.
+	*  Holes of removed members stay where they are.
+	*/
+    void sort();
+
+    /**
+	*  Put member to sleep. Sleeping members aren't updated at all (group walks list of awake
+	*  members only), but they are still drawn and they collide. Move sleeping members only
+	*  through <code>wake()</code>. During parallel update member sleeps after all members are updated.
+	*  @param member Member to put to sleep
+	*/
+    void sleep(FlxBasic *member);
+
+    /**
+	*  Wake sleeping member up (it's updated again from the next frame, or from the current one
+	*  if it's not updated yet). During parallel update member is woken after all members are updated.
+	*  @param member Member to wake
+	*/
+    void wake(FlxBasic *member);
+
+    /**
+	*  Wake sleeping objects which centers lie in area (e.g. around player, or trigger zone)
+	*  @param area Area in world coordinates
+	*  @return Count of woken objects
+	*/
+    unsigned int wakeInRect(const FlxRect& area);
+
+    /**
+	*  Get count of awake members (updated every frame)
+	*  @return Awake members count
+	*/
+    unsigned int getAwakeCount();
+
+    /**
+	*  Get count of sleeping members
+	*  @return Sleeping members count
+	*/
+    unsigned int getAsleepCount();
+
+    /**
+	*  Prepare spatial hash (or packed boxes) for <code>queryBroadphase()</code> (Internal! Do not touch!)
+	*  @return <code>false</code> if group doesn't use broadphase now
+	*/
+    bool prepareBroadphase();
+
+    /**
+	*  Call function for every object member which may touch area (its hitbox, swept by velocity
+	*  in one step, overlaps area) and for every subgroup. Members removed meanwhile are skipped.
+	*  Used by collision functions.
+	*  @param area Area to check
+	*  @param visit Function called with every found member
+	*  @return <code>false</code> if group doesn't use broadphase now (<code>visit</code> isn't called)
+	*/
+    template<class F> bool queryBroadphase(const FlxBox& area, F visit) {
+        if(!prepareBroadphase()) return false;
+
+        broadphaseQueries++;
+
+        auto visitMember = [&](unsigned int id) {
+            unsigned int index = broadphaseIndices[id];
+            if(index < members.size() && members[index] == broadphaseMembers[id]) visit(members[index]);
+        };
+
+        if(builtPacked) packedBoxes.query(area, visitMember);
+        else if(builtMode == FLX_BROADPHASE_QUADTREE) quadTree.query(area, visitMember);
+        else spatialHash.query(area, visitMember);
+
+        for(unsigned int i = 0; i < broadphaseGroups.size(); i++) {
+            unsigned int index = broadphaseGroups[i];
+            if(index < members.size() && members[index] && members[index]->entityType == FLX_GROUP) visit(members[index]);
+        }
+
+        broadphaseQueries--;
+        return true;
+    }
+
+    /**
+	*  Check object against group without walking its members. Groups which know faster way
+	*  (like <code>FlxTilemap</code>) override it. Used by <code>FlxObject::overlaps()</code> and
+	*  <code>FlxObject::collide()</code>.
+	*  @param object Object to check
+	*  @param separate <code>true</code> if object should be stopped (<code>collide()</code>)
+	*  @param callback Callback. See <code>FlxBasic::CollisionCallback</code>
+	*  @param hit Set to the last entity which object hit (or <code>NULL</code>)
+	*  @return <code>false</code> if group doesn't know faster way (members are checked one by one)
+	*/
+    virtual bool checkObject(FlxObject *object, bool separate, const CollisionCallback& callback, FlxBasic *&hit) {
+        (void)object; (void)separate; (void)callback; (void)hit;
+        return false;
+    }
+
     /**
 	*  Check collision between two entities
 	*  @param object Entity to check
@@ -86,40 +490,52 @@ public:
     virtual FlxBasic* collide(FlxBasic *object, const CollisionCallback& callback = nullptr);
 
     /**
-	*  Check collision between two entities inside the same group
+	*  Check collision between two entities inside the same group. Members are swept along
+	*  the axis they are spread the most, so only pairs near each other are checked. Every pair
+	*  is checked (and passed to callback) once, dead members are skipped.
 	*  @param callback Callback. See <code>FlxBasic::CollisionCallback</code>
 	*  @return Set of two elements which overlaps
 	*/
     EntitiesSet selfOverlaps(const CollisionCallback& callback = nullptr);
 
     /**
-	*  Check collision between two entities inside the same group and do some physics work
+	*  Check collision between two entities inside the same group and do some physics work.
+	*  Works like <code>selfOverlaps()</code> with hitboxes swept by velocity. Both members of
+	*  pair are stopped, but callback is called once.
 	*  @param callback Callback. See <code>FlxBasic::CollisionCallback</code>
 	*  @return Set of two elements which overlaps
 	*/
     EntitiesSet selfCollide(const CollisionCallback& callback = nullptr);
 
 	/**
-	*  Update event.
+	*  Update event. Inactive members (see <code>FlxBasic::active</code>) and sleeping ones are skipped.
 	*/
     virtual void update();
 	
 	/**
-	*  Draw all elements flagged as GUI
+	*  Draw all elements flagged as GUI. Like <code>draw()</code>, it walks flattened list of
+	*  the whole subtree.
 	*/
     virtual void drawGUI();
 	
 	/**
-	*  Draw all elements flagged as non-GUI
+	*  Draw all elements flagged as non-GUI. Objects of nested groups are collected into flat
+	*  list in draw order, which is rebuilt only when members of any group in subtree change
+	*  (or <code>isGUI</code> flag of some object changes), so every frame is a linear walk.
+	*  Groups without subgroups walk <code>members</code> directly.
 	*/
     virtual void draw();
 
 
     // inline stuff for script engine
-    inline bool _isObject(int id) { return members[id]->entityType == FLX_OBJECT; }
-    inline bool _isGroup(int id) { return members[id]->entityType == FLX_GROUP; }
-    inline FlxObject* _getObject(int id) { return (FlxObject*) members[id]; }
-    inline FlxGroup* _getGroup(int id) { return (FlxGroup*) members[id]; }
+    inline bool _isObject(int id) { return _isMember(id, FLX_OBJECT); }
+    inline bool _isGroup(int id) { return _isMember(id, FLX_GROUP); }
+    inline FlxObject* _getObject(int id) { return _isObject(id) ? (FlxObject*) members[id] : NULL; }
+    inline FlxGroup* _getGroup(int id) { return _isGroup(id) ? (FlxGroup*) members[id] : NULL; }
+
+    inline bool _isMember(int id, FlxEntityType type) {
+        return id >= 0 && id < (int)members.size() && members[id] && members[id]->entityType == type;
+    }
 };
 
 #endif
@@ -0,0 +1,96 @@
+/*
+   This file is a part of "Flixel C++ port" project
+   Copyrights (c) by Michał Korman 2012
+*/
+#ifndef _FLX_HANDLES_H_
+#define _FLX_HANDLES_H_
+
+#include "backend/cpp.h"
+
+class FlxBasic;
+class FlxObject;
+class FlxGroup;
+
+/**
+*  Generational handle of entity (slot index and generation of slot). Handles of destroyed
+*  entities never resolve, even if their slot is reused.
+*/
+typedef unsigned int FlxHandle;
+
+/**
+*  Handle which never resolves (default value for handles stored in tables)
+*/
+#define FLX_NO_HANDLE 0
+
+
+/**
+*  Slot map of all entities (every <code>FlxBasic</code> gets its handle in constructor and
+*  releases it in destructor). Handles are 32-bit, so they are safe to keep in long-living
+*  structures (camera target, scripts, tables of subsystems) instead of raw pointers, and they
+*  can be checked and resolved in constant time.<br />
+*  Entities can be created and destroyed on any thread. Resolving doesn't lock anything.
+*/
+class FlxHandles {
+
+private:
+    // object and generation are read without lock, nextFree is used under lock only
+    struct Slot {
+        std::atomic<FlxBasic*> object;
+        std::atomic<unsigned int> generation;
+        unsigned int nextFree;
+
+        Slot() : object(NULL), generation(0), nextFree(0) { }
+    };
+
+    static Slot* getSlot(unsigned int index);
+public:
+
+    /**
+    *  Register entity (Internal! Do not touch!)
+    *  @param object Entity
+    *  @return New handle
+    */
+    static FlxHandle create(FlxBasic *object);
+
+    /**
+    *  Unregister entity (Internal! Do not touch!)
+    *  @param handle Handle of destroyed entity
+    */
+    static void destroy(FlxHandle handle);
+
+    /**
+    *  Get entity
+    *  @param handle Handle of entity
+    *  @return Entity or <code>NULL</code> if it doesn't exist anymore
+    */
+    static FlxBasic* resolve(FlxHandle handle);
+
+    /**
+    *  Get object
+    *  @param handle Handle of object
+    *  @return Object or <code>NULL</code> if it doesn't exist anymore or it's a group
+    */
+    static FlxObject* getObject(FlxHandle handle);
+
+    /**
+    *  Get group
+    *  @param handle Handle of group
+    *  @return Group or <code>NULL</code> if it doesn't exist anymore or it's an object
+    */
+    static FlxGroup* getGroup(FlxHandle handle);
+
+    /**
+    *  Check if entity still exists
+    *  @param handle Handle to check
+    *  @return <code>true</code> if handle resolves
+    */
+    static bool isValid(FlxHandle handle);
+
+    /**
+    *  Get count of existing entities
+    *  @return Entities count
+    */
+    static unsigned int getCount();
+};
+
+#endif
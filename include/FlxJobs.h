@@ -0,0 +1,161 @@
+/*
+   This file is a part of "Flixel C++ port" project
+   Copyrights (c) by Michał Korman 2012
+*/
+#ifndef _FLX_JOBS_H_
+#define _FLX_JOBS_H_
+
+#include "backend/cpp.h"
+#include <deque>
+#include <memory>
+
+struct FlxJob;
+
+/**
+*  Handle of scheduled job (can be used as dependency of other jobs)
+*/
+typedef std::shared_ptr<FlxJob> FlxJobHandle;
+
+
+/**
+*  Work-stealing jobs system.<br />
+*  Every worker thread (and main thread) has its own jobs queue. Owner takes the newest jobs
+*  from its queue, idle threads steal the oldest jobs from other queues. Thread which waits
+*  for job executes other jobs in the meantime, so waiting from job is safe.<br />
+*  With 0 workers (or <code>FLX_NO_THREADS</code> macro) all jobs are run immediately on
+*  calling thread.
+*/
+class FlxJobs {
+
+public:
+
+    /**
+    *  Single job function
+    */
+    typedef std::function<void()> Task;
+
+    /**
+    *  Range job function, called with range <code>[begin, end)</code>
+    */
+    typedef std::function<void(unsigned int begin, unsigned int end)> RangeTask;
+
+private:
+    struct Queue {
+        std::deque<FlxJobHandle> jobs;
+        FlxMutex mutex;
+    };
+
+    std::vector<Queue*> queues;
+    std::atomic<int> queuedJobs;
+    std::atomic<unsigned int> nextQueue;
+    std::atomic<bool> running;
+    bool initialized;
+
+    #ifndef FLX_NO_THREADS
+    std::vector<std::thread*> threads;
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    #endif
+
+    std::vector<Task> mainThreadTasks;
+    FlxMutex mainThreadMutex;
+
+    void schedule(const FlxJobHandle& job);
+    void push(const FlxJobHandle& job);
+    FlxJobHandle pop(int index);
+    void execute(const FlxJobHandle& job);
+    void workerLoop(unsigned int index);
+public:
+
+    /**
+    *  Default constructor (doesn't start any threads)
+    */
+    FlxJobs();
+
+    /**
+    *  Destructor, stops workers
+    */
+    ~FlxJobs();
+
+    /**
+    *  Start worker threads (restarts them if they are already running). Must be called
+    *  from main thread.
+    *  @param workers Count of workers (-1 = one less than hardware threads)
+    */
+    void init(int workers = -1);
+
+    /**
+    *  Finish all queued jobs and stop worker threads
+    */
+    void shutdown();
+
+    /**
+    *  Are workers started?
+    *  @return <code>true</code> if <code>init()</code> was called
+    */
+    bool isInitialized();
+
+    /**
+    *  Get count of worker threads (without main thread)
+    *  @return Count of workers
+    */
+    unsigned int getWorkersCount();
+
+    /**
+    *  Schedule job
+    *  @param task Function to run
+    *  @return Job handle
+    */
+    FlxJobHandle add(const Task& task);
+
+    /**
+    *  Schedule job which starts after other job is finished
+    *  @param task Function to run
+    *  @param dependency Job to wait for (may be empty)
+    *  @return Job handle
+    */
+    FlxJobHandle add(const Task& task, const FlxJobHandle& dependency);
+
+    /**
+    *  Schedule job which starts after all specified jobs are finished
+    *  @param task Function to run
+    *  @param dependencies Jobs to wait for
+    *  @return Job handle
+    */
+    FlxJobHandle add(const Task& task, const std::vector<FlxJobHandle>& dependencies);
+
+    /**
+    *  Is job finished?
+    *  @param job Job handle
+    *  @return <code>true</code> if job is finished (or handle is empty)
+    */
+    bool isDone(const FlxJobHandle& job);
+
+    /**
+    *  Wait for job, executing other jobs in the meantime
+    *  @param job Job handle
+    */
+    void wait(const FlxJobHandle& job);
+
+    /**
+    *  Split range into chunks and run them on all threads. Returns when whole range is done.
+    *  @param begin First index
+    *  @param end Index after the last one
+    *  @param task Function called for every chunk
+    *  @param grain Minimum chunk size (0 = choose automatically)
+    */
+    void parallelFor(unsigned int begin, unsigned int end, const RangeTask& task, unsigned int grain = 0);
+
+    /**
+    *  Run function on main thread at the beginning of next frame (can be called from any thread)
+    *  @param task Function to run
+    */
+    void runOnMainThread(const Task& task);
+
+    /**
+    *  Run functions queued by <code>runOnMainThread()</code> (called by framework every frame)
+    */
+    void update();
+};
+
+#endif
@@ -0,0 +1,89 @@
+/*
+   This file is a part of "Flixel C++ port" project
+   Copyrights (c) by Michał Korman 2012
+*/
+#ifndef _FLX_KINEMATICS_H_
+#define _FLX_KINEMATICS_H_
+
+#include "backend/cpp.h"
+
+/**
+*  Batch motion integrator.<br />
+*  Integrates motion fields kept in aligned arrays (structure of arrays) with the same math as
+*  <code>FlxObject::update()</code>. Kernel (scalar, SSE or AVX) is selected at runtime, the best
+*  one supported by CPU is used by default.
+*/
+class FlxKinematics {
+
+public:
+
+    /**
+    *  Integration code path
+    */
+    enum Kernel {
+        SCALAR,
+        SSE,
+        AVX
+    };
+
+    /**
+    *  Motion fields (arrays of batch)
+    */
+    enum Field {
+        X,
+        Y,
+        VELOCITY_X,
+        VELOCITY_Y,
+        ACCELERATION_X,
+        ACCELERATION_Y,
+        MAX_VELOCITY_X,
+        MAX_VELOCITY_Y,
+        ANGLE,
+        ANGULAR_VELOCITY,
+        FIELDS_COUNT
+    };
+
+private:
+    static Kernel kernel;
+
+    static Kernel selectKernel();
+public:
+
+    /**
+    *  Integrate arrays of motion fields
+    *  @param fields Arrays indexed by <code>Field</code> (aligned to 32 bytes and padded to 8 elements)
+    *  @param count Count of elements
+    *  @param dt Time step (in seconds)
+    */
+    static void integrate(float * const *fields, unsigned int count, float dt);
+
+    /**
+    *  Get currently used kernel
+    *  @return Kernel
+    */
+    static Kernel getKernel();
+
+    /**
+    *  Force kernel (e.g. for benchmarks). Unsupported kernels are ignored. Don't call it while
+    *  groups are updated.
+    *  @param k Kernel to use
+    *  @return <code>true</code> if kernel is supported by CPU and build
+    */
+    static bool setKernel(Kernel k);
+
+    /**
+    *  Check if kernel can be used on this CPU
+    *  @param k Kernel to check
+    *  @return <code>true</code> if kernel is supported
+    */
+    static bool isSupported(Kernel k);
+
+    /**
+    *  Get human-readable kernel name
+    *  @param k Kernel
+    *  @return "Scalar", "SSE" or "AVX"
+    */
+    static const char* getKernelName(Kernel k);
+};
+
+#endif
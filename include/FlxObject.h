@@ -24,6 +24,7 @@ class FlxObject : public FlxBasic {
 
 private:
     FlxPath::Node currentNode;
+    unsigned int lastUpdate;
 public:
 
     /**
@@ -36,6 +37,11 @@ public:
 	*/
     float y;
 
+	/**
+	* Depth (groups with <code>FLX_SORT_Z</code> draw lower values first)
+	*/
+    float z;
+
 	/**
 	* Width of the entity
 	*/
@@ -71,6 +77,16 @@ public:
 	*/
     float angle;
 
+	/**
+	* Position from previous fixed update (used by render interpolation)
+	*/
+    FlxVector last;
+
+	/**
+	* Rotation from previous fixed update (used by render interpolation)
+	*/
+    float lastAngle;
+
 	/**
 	* Scale factor
 	*/
@@ -139,6 +155,32 @@ public:
 	*/
     FlxVector getCenter();
 
+	/**
+	*  Get position to draw entity at. If <code>FlxG::interpolation</code> is enabled it's
+	*  between previous and current fixed update position.
+	*  @return Position to draw entity at
+	*/
+    FlxVector getDrawPosition();
+
+	/**
+	*  Get rotation to draw entity with (see <code>getDrawPosition()</code>)
+	*  @return Rotation to draw entity with
+	*/
+    float getDrawAngle();
+
+	/**
+	*  Forget previous position, so entity isn't interpolated in current frame.
+	*  Call it after teleporting entity.
+	*/
+    void resetInterpolation();
+
+	/**
+	*  Get key of texture used to draw entity. Sorted groups put entities with the same
+	*  texture next to each other, so backend switches textures less often.
+	*  @return Texture key or <code>NULL</code> if entity doesn't draw any texture
+	*/
+    virtual const void* getTextureKey();
+
 
 	/**
 	*  Is entity touching object below?
@@ -187,6 +229,11 @@ public:
 	*/
     virtual void kill();
 
+	/**
+	*  Bring killed object back to life (active and visible)
+	*/
+    virtual void revive();
+
 	/**
 	*  Default constructor
 	*/
@@ -0,0 +1,147 @@
+/*
+   This file is a part of "Flixel C++ port" project
+   Copyrights (c) by Michał Korman 2012
+*/
+#ifndef _FLX_PROFILER_H_
+#define _FLX_PROFILER_H_
+
+#include "backend/cpp.h"
+
+/**
+*  Single finished profiler zone
+*/
+struct FlxProfilerZone {
+
+    /**
+    *  Zone name (must be string with static storage, e.g. literal)
+    */
+    const char *name;
+
+    /**
+    *  Start and end time (in nanoseconds since profiler initialization)
+    */
+    unsigned long long start, end;
+
+    /**
+    *  Frame in which zone was closed
+    */
+    unsigned int frame;
+
+    /**
+    *  Nesting level (0 = top level zone)
+    */
+    unsigned short depth;
+};
+
+
+/**
+*  Scoped zones frame profiler.<br />
+*  Every thread records finished zones into its own ring buffer. Its lock is shared only with
+*  trace export, so threads never wait for each other while profiling. When profiler is
+*  disabled zones cost a single flag check, and with
+*  <code>FLX_NO_PROFILER</code> macro they aren't compiled at all.<br />
+*  Recorded zones can be exported to Chrome trace-event JSON format (chrome://tracing, Perfetto).
+*/
+class FlxProfiler {
+
+public:
+
+    /**
+    *  Is profiler recording zones? Default: <code>false</code>
+    */
+    static bool enabled;
+
+    /**
+    *  Open new zone on current thread (use <code>FLX_PROFILE_ZONE</code> instead)
+    *  @param name Zone name (must be string with static storage, e.g. literal)
+    */
+    static void beginZone(const char *name);
+
+    /**
+    *  Close last opened zone on current thread
+    */
+    static void endZone();
+
+    /**
+    *  Mark end of frame. Called by framework after every rendered frame.
+    */
+    static void frameMark();
+
+    /**
+    *  Get number of current frame
+    *  @return Frames counter
+    */
+    static unsigned int getFrame();
+
+    /**
+    *  Get time since profiler initialization
+    *  @return Time in nanoseconds
+    */
+    static unsigned long long getTime();
+
+    /**
+    *  Set name of current thread (shown in trace viewer)
+    *  @param name Thread name
+    */
+    static void setThreadName(const char *name);
+
+    /**
+    *  Set ring buffers capacity. Affects only threads which haven't recorded anything yet.
+    *  @param zones Maximum count of stored zones per thread. Default: 65536
+    */
+    static void setBufferSize(unsigned int zones);
+
+    /**
+    *  Remove all recorded zones
+    */
+    static void clear();
+
+    /**
+    *  Save recorded zones as Chrome trace-event JSON. Other threads can record zones meanwhile.
+    *  @param path Output file path (in external device's storage)
+    *  @param frames How many last finished frames to save (0 = everything in buffers)
+    *  @return <code>true</code> on success
+    */
+    static bool exportTrace(const char *path, unsigned int frames = 0);
+
+    /**
+    *  Enable profiler (if needed) and save next finished frame to file
+    *  @param path Output file path (in external device's storage)
+    */
+    static void captureFrame(const char *path);
+};
+
+
+/**
+*  Zone living as long as this object (use <code>FLX_PROFILE_ZONE</code> macro)
+*/
+class FlxProfilerScope {
+
+private:
+    bool active;
+public:
+
+    FlxProfilerScope(const char *name) {
+        active = FlxProfiler::enabled;
+        if(active) FlxProfiler::beginZone(name);
+    }
+
+    ~FlxProfilerScope() {
+        if(active) FlxProfiler::endZone();
+    }
+};
+
+
+#define FLX_PROFILE_CONCAT_INNER(a, b) a##b
+#define FLX_PROFILE_CONCAT(a, b) FLX_PROFILE_CONCAT_INNER(a, b)
+
+/**
+*  Profile current scope as zone with specified name
+*/
+#ifndef FLX_NO_PROFILER
+    #define FLX_PROFILE_ZONE(name) FlxProfilerScope FLX_PROFILE_CONCAT(flxProfilerZone, __LINE__)(name)
+#else
+    #define FLX_PROFILE_ZONE(name)
+#endif
+
+#endif
@@ -0,0 +1,208 @@
+/*
+   This file is a part of "Flixel C++ port" project
+   Copyrights (c) by Michał Korman 2012
+*/
+#ifndef _FLX_QUAD_TREE_H_
+#define _FLX_QUAD_TREE_H_
+
+#include "backend/cpp.h"
+#include "FlxRect.h"
+#include <algorithm>
+
+
+/**
+*  Loose quadtree of boxes. Box is kept in the smallest node which cell is not smaller than
+*  the box and contains its center. Nodes are checked by their loose bounds (cell grown by half
+*  of its size on every side), so box never crosses them and moving box is relinked only when
+*  its center leaves the cell or its size changes a lot. Big boxes stay near the root, small
+*  ones deep in the tree, so levels mixing huge platforms with tiny bullets work well.<br />
+*  Boxes outside of tree's bounds are kept in the root. Queries don't change anything.
+*/
+class FlxQuadTree {
+
+public:
+
+    /**
+    *  Maximum depth of tree
+    */
+    static const unsigned int MaxDepth = 12;
+
+private:
+    struct Node {
+        float minX, minY, size;
+        unsigned int depth;
+        int parent;
+        int children[4];
+        int firstItem;
+
+        // boxes in the whole subtree (empty subtrees are skipped by queries)
+        unsigned int count;
+    };
+
+    struct Item {
+        FlxBox box;
+        int node;
+        int prev, next;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Item> items;
+    std::vector<unsigned int> freeItems;
+    FlxBox bounds;
+    unsigned int depthLimit;
+    unsigned int itemsCount;
+
+    int createNode(float minX, float minY, float size, unsigned int depth, int parent);
+    int findNode(const FlxBox& box);
+    void link(unsigned int id, int node);
+    void unlink(unsigned int id);
+
+    bool isLooseOverlap(const Node& node, const FlxBox& area) const {
+        float margin = node.size * 0.5f;
+
+        return node.minX - margin <= area.maxX && area.minX <= node.minX + node.size + margin &&
+               node.minY - margin <= area.maxY && area.minY <= node.minY + node.size + margin;
+    }
+public:
+
+    /**
+    *  Default constructor (bounds 0, 0, 1024, 1024)
+    */
+    FlxQuadTree();
+
+    /**
+    *  Set area covered by tree. Removes all boxes.
+    *  @param area Area of tree (it's made square)
+    *  @param maxDepth Depth of the smallest nodes (up to <code>MaxDepth</code>)
+    */
+    void setBounds(const FlxBox& area, unsigned int maxDepth = 8);
+
+    /**
+    *  Get area covered by tree
+    *  @return Square bounds of root
+    */
+    const FlxBox& getBounds() const {
+        return bounds;
+    }
+
+    /**
+    *  Remove all boxes (ids are given from 0 again)
+    */
+    void clear();
+
+    /**
+    *  Add box
+    *  @param box Box to add
+    *  @return Id of box (ids of removed boxes are reused)
+    */
+    unsigned int insert(const FlxBox& box);
+
+    /**
+    *  Remove box
+    *  @param id Id of box
+    */
+    void remove(unsigned int id);
+
+    /**
+    *  Change box (it's relinked only when it doesn't fit its node anymore)
+    *  @param id Id of box
+    *  @param box New box
+    */
+    void move(unsigned int id, const FlxBox& box);
+
+    /**
+    *  Get box
+    *  @param id Id of box
+    *  @return Box
+    */
+    const FlxBox& getBox(unsigned int id) const {
+        return items[id].box;
+    }
+
+    /**
+    *  Get count of boxes
+    *  @return Boxes count
+    */
+    unsigned int size() const {
+        return itemsCount;
+    }
+
+    /**
+    *  Get count of nodes (including empty ones)
+    *  @return Nodes count
+    */
+    unsigned int getNodesCount() const {
+        return nodes.size();
+    }
+
+    /**
+    *  Call function for every box which overlaps area (edges touching count as overlap)
+    *  @param area Area to check
+    *  @param visit Function called with id of every found box
+    */
+    template<class F> void query(const FlxBox& area, F visit) const {
+        if(itemsCount == 0) return;
+
+        // depth-first, every level pushes at most 3 siblings more than it pops
+        int stack[MaxDepth * 3 + 2];
+        int top = 0;
+        stack[top++] = 0;
+
+        while(top > 0) {
+            const Node& node = nodes[stack[--top]];
+
+            for(int i = node.firstItem; i >= 0; i = items[i].next) {
+                if(items[i].box.overlaps(area)) visit((unsigned int) i);
+            }
+
+            for(int c = 0; c < 4; c++) {
+                int child = node.children[c];
+                if(child >= 0 && nodes[child].count > 0 && isLooseOverlap(nodes[child], area)) stack[top++] = child;
+            }
+        }
+    }
+
+    /**
+    *  Call function for every pair of overlapping boxes (every pair once)
+    *  @param visit Function called with ids of both boxes (the first one is lower)
+    */
+    template<class F> void queryPairs(F visit) const {
+        int stack[MaxDepth * 3 + 2];
+
+        // pair is found from the shallower box, so boxes in nodes above it aren't checked
+        for(unsigned int n = 0; n < nodes.size(); n++) {
+            unsigned int depth = nodes[n].depth;
+
+            for(int a = nodes[n].firstItem; a >= 0; a = items[a].next) {
+                const FlxBox& box = items[a].box;
+                int top = 0;
+                stack[top++] = 0;
+
+                while(top > 0) {
+                    int current = stack[--top];
+                    const Node& node = nodes[current];
+
+                    if(node.depth > depth || (node.depth == depth && current != (int) n)) {
+                        for(int b = node.firstItem; b >= 0; b = items[b].next) {
+                            if((node.depth > depth || b > a) && box.overlaps(items[b].box)) {
+                                visit((unsigned int) std::min(a, b), (unsigned int) std::max(a, b));
+                            }
+                        }
+                    }
+                    else if(current == (int) n) {
+                        for(int b = items[a].next; b >= 0; b = items[b].next) {
+                            if(box.overlaps(items[b].box)) visit((unsigned int) std::min(a, b), (unsigned int) std::max(a, b));
+                        }
+                    }
+
+                    for(int c = 0; c < 4; c++) {
+                        int child = node.children[c];
+                        if(child >= 0 && nodes[child].count > 0 && isLooseOverlap(nodes[child], box)) stack[top++] = child;
+                    }
+                }
+            }
+        }
+    }
+};
+
+#endif
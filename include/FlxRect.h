@@ -65,6 +65,18 @@ public:
     }
 };
 
+
+/**
+*  Axis-aligned box given by its corners (used by broadphases, edges touching count as overlap)
+*/
+struct FlxBox {
+    float minX, minY, maxX, maxY;
+
+    bool overlaps(const FlxBox& second) const {
+        return minX <= second.maxX && second.minX <= maxX && minY <= second.maxY && second.minY <= maxY;
+    }
+};
+
 #endif
 
 
@@ -0,0 +1,175 @@
+/*
+   This file is a part of "Flixel C++ port" project
+   Copyrights (c) by Michał Korman 2012
+*/
+#ifndef _FLX_RENDERER_H_
+#define _FLX_RENDERER_H_
+
+#include "backend/cpp.h"
+#include "FlxBackendBase.h"
+
+/**
+*  Single recorded draw call
+*/
+struct FlxDrawCommand {
+
+    /**
+    *  Kind of draw call
+    */
+    enum Type {
+        IMAGE,
+        TEXT,
+        SHADER,
+        IMAGES
+    } type;
+
+    /**
+    *  Drawn image, text or shader (depends on <code>type</code>)
+    */
+    void *data;
+
+    /**
+    *  Transform
+    */
+    float x, y, angle;
+    FlxVector scale;
+
+    /**
+    *  Source rectangle (images only)
+    */
+    FlxRect source;
+
+    /**
+    *  Color, alpha and flipping (images only)
+    */
+    int color;
+    float alpha;
+    bool flipped;
+
+    /**
+    *  Range of sprites in draw list's sprites buffer (batches only)
+    */
+    unsigned int first, count;
+};
+
+
+/**
+*  Draw calls dispatcher.<br />
+*  By default every draw call goes straight to backend. In pipelined mode draw calls of
+*  current frame are recorded into one of two draw lists, while render thread submits
+*  previous frame's list to backend, so simulation and rendering overlap. Backends which
+*  can't render from other thread (GL context bound to main thread) replay the list on main
+*  thread at the end of frame.
+*/
+class FlxRenderer {
+
+private:
+    std::vector<FlxDrawCommand> lists[2];
+    std::vector<FlxBatchSprite> sprites[2];
+    std::vector<FlxBaseText*> garbage;
+    unsigned int recordList;
+    bool pipelined, requested;
+
+    #ifndef FLX_NO_THREADS
+    std::thread *thread;
+    std::mutex mutex;
+    std::condition_variable signal;
+    bool submitted, stopping;
+
+    void renderLoop();
+    #endif
+
+    void start();
+    void replay(unsigned int index);
+    void collectGarbage();
+public:
+
+    /**
+    *  Count of draw calls recorded in last frame (pipelined mode only)
+    */
+    unsigned int lastCommandsCount;
+
+    /**
+    *  Time spent by main thread on waiting for render thread in last frame (in seconds)
+    */
+    float lastWaitTime;
+
+    /**
+    *  Default constructor
+    */
+    FlxRenderer();
+
+    /**
+    *  Destructor, stops render thread
+    */
+    ~FlxRenderer();
+
+    /**
+    *  Turn pipelined mode on or off (since next frame). Render thread is started only if
+    *  backend supports it (see <code>FlxBackendBase::isRenderThreadSupported()</code>).
+    *  @param enabled Record draw calls?
+    */
+    void setPipelined(bool enabled);
+
+    /**
+    *  Is pipelined mode on?
+    *  @return <code>true</code> if draw calls are recorded
+    */
+    bool isPipelined();
+
+    /**
+    *  Is render thread running?
+    *  @return <code>true</code> if draw lists are submitted on render thread
+    */
+    bool hasRenderThread();
+
+    /**
+    *  Start frame (called by main loop)
+    */
+    void beginFrame();
+
+    /**
+    *  Finish frame and hand its draw list to render thread (called by main loop)
+    */
+    void endFrame();
+
+    /**
+    *  Wait until render thread is done with all submitted frames
+    */
+    void flush();
+
+    /**
+    *  Stop render thread and go back to immediate mode (Internal! Do not touch!)
+    */
+    void shutdown();
+
+    /**
+    *  Draw image. See <code>FlxBackendBase::drawImage()</code>
+    */
+    void drawImage(FlxBackendImage *img, float x, float y, const FlxVector& scale, float angle,
+                   const FlxRect& source, int color, bool flipped, float alpha);
+
+    /**
+    *  Draw many sprites of the same image at once. See <code>FlxBackendBase::drawImages()</code>
+    */
+    void drawImages(FlxBackendImage *img, const FlxBatchSprite *batch, unsigned int count,
+                    const FlxVector& scale, int color, float alpha);
+
+    /**
+    *  Draw text. See <code>FlxBackendBase::drawText()</code>
+    */
+    void drawText(FlxBaseText *text, float x, float y, const FlxVector& scale, float angle);
+
+    /**
+    *  Draw shader. See <code>FlxBackendBase::drawShader()</code>
+    */
+    void drawShader(FlxBackendShader *shader);
+
+    /**
+    *  Destroy text data. In pipelined mode it's destroyed when render thread doesn't use it anymore.
+    *  @param text Text created by <code>FlxBackendBase::createText()</code>
+    */
+    void destroyText(FlxBaseText *text);
+};
+
+#endif
@@ -5,6 +5,20 @@
 #ifndef _FLX_SCRIPT_H_
 #define _FLX_SCRIPT_H_
 
+/**
+*  Events called by framework on every script (hooks are resolved once, after script loading)
+*/
+enum FlxScriptEvent {
+    FLX_SCRIPT_APPLICATION_INIT,    // void onApplicationInit()
+    FLX_SCRIPT_APPLICATION_EXIT,    // void onApplicationExit()
+    FLX_SCRIPT_STAGE_BEGIN,         // void onStageBegin()
+    FLX_SCRIPT_STAGE_END,           // void onStageEnd()
+    FLX_SCRIPT_FRAME_ENTER,         // void onFrameEnter()
+    FLX_SCRIPT_RENDER,              // void onRender()
+    FLX_SCRIPT_OBJECTS_CONTACT,     // void onObjectsContact(FlxObject@, FlxObject@)
+    FLX_SCRIPT_EVENTS_COUNT
+};
+
 #ifndef FLX_NO_SCRIPT
 
 #include "backend/cpp.h"
@@ -24,6 +38,9 @@ private:
     FlxScriptEngine *engine;
     CScriptBuilder builder;
     asIScriptModule *mainModule;
+    asIScriptFunction *hooks[FLX_SCRIPT_EVENTS_COUNT];
+
+    void resolveHooks();
 
     friend class FlxScriptEngine;
 public:
@@ -32,7 +49,7 @@ public:
 	*  Default constructor
 	*  @param eng Pointer to script engine
 	*/
-    FlxScript(FlxScriptEngine *eng) { engine = eng; }
+    FlxScript(FlxScriptEngine *eng);
 	
 	/**
 	*  Get AngelScript script builder
@@ -60,10 +77,31 @@ public:
     FLX_CONTEXT *findFunction(const char *funcDecl);
 	
 	/**
-	*  End function calling and delete function context.
+	*  End function calling and give function context back to engine.
 	*  @param ctx Function's context
 	*/
     void endCall(FLX_CONTEXT *ctx);
+
+	/**
+	*  Does script handle specified event?
+	*  @param event Event to check
+	*  @return <code>true</code> if script has function for this event
+	*/
+    inline bool hasEvent(FlxScriptEvent event) { return hooks[event] != NULL; }
+
+	/**
+	*  Call script's event function (does nothing if script doesn't handle event)
+	*  @param event Event to call
+	*/
+    void callEvent(FlxScriptEvent event);
+
+	/**
+	*  Prepare call of event function with arguments. Set arguments, execute context and give
+	*  it back by <code>endCall()</code>.
+	*  @param event Event to call
+	*  @return Function context or <code>NULL</code> if script doesn't handle event
+	*/
+    FLX_CONTEXT *prepareEvent(FlxScriptEvent event);
 };
 
 
@@ -75,6 +113,8 @@ class FlxScriptEngine {
 
 private:
     asIScriptEngine *engine;
+    std::vector<asIScriptContext*> contexts;
+
     void bindFlixelFunctionality();
 public:
 
@@ -94,6 +134,18 @@ public:
 	*/
     inline asIScriptEngine* getCore() { return engine; }
 
+    /**
+	*  Get unused context from pool (or create new one)
+	*  @return Script context
+	*/
+    asIScriptContext* requestContext();
+
+    /**
+	*  Give context back to pool
+	*  @param ctx Context returned by <code>requestContext()</code>
+	*/
+    void returnContext(asIScriptContext *ctx);
+
     /**
 	*  Register global function
 	*  @param decl Declaration of function
@@ -224,6 +276,10 @@ public:
 
 // dummies
 class FlxScript {
+
+public:
+    bool hasEvent(FlxScriptEvent event) { (void)event; return false; }
+    void callEvent(FlxScriptEvent event) { (void)event; }
 };
 
 class FlxScriptEngine {
@@ -278,6 +334,16 @@ public:
         return false;
     }
 	
+    /**
+	*  Call event on all scripts in group
+	*  @param event Event to call
+	*/
+    void callEvent(FlxScriptEvent event) {
+        for(unsigned int i = 0; i < members.size(); i++) {
+            if(members[i]) members[i]->callEvent(event);
+        }
+    }
+
     /**
 	*  Remove all scripts from group
 	*/
@@ -8,26 +8,171 @@
 #include "backend/cpp.h"
 #include "FlxBackendBase.h"
 
+/**
+*  Handle of playing sound instance (0 = no voice)
+*/
+typedef unsigned int FlxVoiceHandle;
+
+
+/**
+*  Fixed-capacity pool of backend sound voices.<br />
+*  Voices are created once and reused, so playing sound doesn't allocate anything. When pool
+*  is full, voice with the lowest priority (the oldest one on tie) is stolen. Every sound
+*  also has limit of simultaneously playing instances - the oldest instance is restarted
+*  when limit is reached.
+*/
+class FlxVoicePool {
+
+private:
+    struct Voice {
+        FlxBackendSound *sound;
+        void *buffer;
+        int priority;
+        unsigned int generation;
+        unsigned int activeIndex;
+        unsigned long long order;
+    };
+
+    std::vector<Voice> voices;
+    std::vector<unsigned int> active;
+    std::vector<unsigned int> freeVoices;
+    std::map<void*, unsigned int> instances;
+    std::map<void*, unsigned int> limits;
+    unsigned int capacity;
+    unsigned long long playCounter;
+
+    int acquire(void *buffer, int priority);
+    void release(unsigned int index);
+    Voice* getVoice(FlxVoiceHandle handle);
+public:
+
+    /**
+    *  Default limit of simultaneously playing instances of single sound (0 = no limit). Default: 8
+    */
+    unsigned int maxInstances;
+
+    /**
+    *  Count of voices stolen from other sounds
+    */
+    unsigned long long stolenVoices;
+
+    /**
+    *  Count of sounds which weren't played (all voices had higher priority)
+    */
+    unsigned long long rejectedSounds;
+
+    /**
+    *  Default constructor
+    */
+    FlxVoicePool();
+
+    /**
+    *  Set maximum count of voices (default: 32). Voices are created on demand.
+    *  @param voices Maximum count of voices
+    */
+    void setCapacity(unsigned int voices);
+
+    /**
+    *  Get maximum count of voices
+    *  @return Maximum count of voices
+    */
+    unsigned int getCapacity();
+
+    /**
+    *  Get count of currently playing voices
+    *  @return Count of playing voices
+    */
+    unsigned int getActiveCount();
+
+    /**
+    *  Set limit of simultaneously playing instances for specified sound
+    *  @param sound Sound returned by <code>FlxBackendBase::loadSound()</code>
+    *  @param count Maximum count of instances (0 = no limit)
+    */
+    void setMaxInstances(void *sound, unsigned int count);
+
+    /**
+    *  Play sound on free (or stolen) voice
+    *  @param sound Sound returned by <code>FlxBackendBase::loadSound()</code>
+    *  @param vol Volume in range 0 - 1
+    *  @param priority Sound priority (voices of lower priority sounds are stolen first)
+    *  @param looped Play sound infinitely?
+    *  @return Voice handle or 0 if sound couldn't be played
+    */
+    FlxVoiceHandle play(void *sound, float vol, int priority = 0, bool looped = false);
+
+    /**
+    *  Stop voice (does nothing if voice was already reused)
+    *  @param handle Voice handle
+    */
+    void stop(FlxVoiceHandle handle);
+
+    /**
+    *  Is voice still playing?
+    *  @param handle Voice handle
+    *  @return <code>true</code> if it's playing, <code>false</code> if it's not
+    */
+    bool isPlaying(FlxVoiceHandle handle);
+
+    /**
+    *  Change volume of playing voice
+    *  @param handle Voice handle
+    *  @param vol Volume in range 0 - 1
+    */
+    void setVolume(FlxVoiceHandle handle, float vol);
+
+    /**
+    *  Change looping of playing voice
+    *  @param handle Voice handle
+    *  @param loop Play infinitely?
+    */
+    void setLooped(FlxVoiceHandle handle, bool loop);
+
+    /**
+    *  Give finished voices back to pool (called by framework every update)
+    */
+    void update();
+
+    /**
+    *  Stop all voices
+    */
+    void stopAll();
+
+    /**
+    *  Stop and destroy all voices (Internal! Do not touch!)
+    */
+    void clear();
+};
+
+
 /**
 *  Sound object
 */
 class FlxSound {
 
 private:
-    FlxBackendSound *soundPtr;
     void *soundBufferPtr;
+    FlxVoiceHandle voice;
+    bool looped;
 public:
 
 	/**
-	*  All active sound objects (Internal! Do not touch!)
+	*  Pool of voices used by all sounds
 	*/
-    static std::vector<FlxBackendSound*> Sounds;
+    static FlxVoicePool Voices;
+
+	/**
+	*  Sound priority. When there is no free voice, sounds with lower priority are stopped first.
+	*  Default: 0
+	*/
+    int priority;
 
 	/**
 	*  Default constructor
 	*  @param path Path to sound file (Must be in local device storage)
+	*  @param priority Sound priority
 	*/
-    FlxSound(const char *path);
+    FlxSound(const char *path, int priority = 0);
 
 	/**
 	*  Play sound
@@ -47,10 +192,22 @@ public:
     bool isPlaying();
 
 	/**
-	*  Should sound be played infinitely? (<b>NOTE: This function is currently bugged</b>)
+	*  Should sound be played infinitely?
 	*  @return loop Yes or no
 	*/
     void setLooped(bool loop);
+
+	/**
+	*  Change volume of playing sound
+	*  @param vol Volume in range 0 - 1
+	*/
+    void setVolume(float vol);
+
+	/**
+	*  Set limit of simultaneously playing instances of this sound (all objects with the same path)
+	*  @param count Maximum count of instances (0 = no limit)
+	*/
+    void setMaxInstances(unsigned int count);
 };
 
 #endif
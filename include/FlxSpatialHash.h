@@ -0,0 +1,165 @@
+/*
+   This file is a part of "Flixel C++ port" project
+   Copyrights (c) by Michał Korman 2012
+*/
+#ifndef _FLX_SPATIAL_HASH_H_
+#define _FLX_SPATIAL_HASH_H_
+
+#include "backend/cpp.h"
+#include "FlxRect.h"
+#include <algorithm>
+
+
+/**
+*  Uniform grid broadphase. Boxes are inserted into every cell they cover, cells are hashed
+*  into fixed table of buckets, so the world doesn't have to be bounded. Table is rebuilt
+*  from scratch (two counting passes over boxes, no allocations after warm-up).<br />
+*  Queries don't change anything, so they can run on many threads at once and from inside
+*  of other queries. Every box is reported once per query.
+*/
+class FlxSpatialHash {
+
+public:
+
+    /**
+    *  Axis-aligned box (min and max corners)
+    */
+    typedef FlxBox Box;
+
+private:
+    struct Item {
+        Box box;
+        int cellX0, cellY0, cellX1, cellY1;
+    };
+
+    std::vector<Item> items;
+    std::vector<unsigned int> bucketStarts;
+    std::vector<unsigned int> entries;
+
+    // boxes covering too many cells are checked by every query
+    std::vector<unsigned int> largeItems;
+
+    float cellSize, invCellSize;
+    unsigned int bucketMask;
+    bool built;
+
+    int getCell(float coord) const;
+    void getCells(const Box& box, int& x0, int& y0, int& x1, int& y1) const;
+
+    static unsigned int hashCell(int x, int y) {
+        return ((unsigned int) x * 73856093u) ^ ((unsigned int) y * 19349663u);
+    }
+public:
+
+    /**
+    *  Maximum count of cells covered by single box. Bigger boxes are kept aside and tested
+    *  by every query.
+    */
+    static const unsigned int MaxCellsPerBox = 64;
+
+    /**
+    *  Default constructor
+    */
+    FlxSpatialHash();
+
+    /**
+    *  Remove all boxes
+    */
+    void clear();
+
+    /**
+    *  Start building new table (previous boxes are removed)
+    *  @param cellSize Size of cell (about twice the size of typical box works well)
+    */
+    void begin(float cellSize);
+
+    /**
+    *  Add box. Boxes are numbered in order of adding, starting from 0.
+    *  @param box Box to add
+    *  @return Id of box
+    */
+    unsigned int insert(const Box& box);
+
+    /**
+    *  Distribute added boxes into cells. Call it before queries.
+    */
+    void end();
+
+    /**
+    *  Get count of boxes
+    *  @return Boxes count
+    */
+    unsigned int size() const {
+        return items.size();
+    }
+
+    /**
+    *  Get cell size
+    *  @return Size of cell
+    */
+    float getCellSize() const {
+        return cellSize;
+    }
+
+    /**
+    *  Get box
+    *  @param id Id of box
+    *  @return Box
+    */
+    const Box& getBox(unsigned int id) const {
+        return items[id].box;
+    }
+
+    /**
+    *  Call function for every box which overlaps area (edges touching count as overlap)
+    *  @param area Area to check
+    *  @param visit Function called with id of every found box
+    */
+    template<class F> void query(const Box& area, F visit) const {
+        if(!built || items.empty()) return;
+
+        int x0, y0, x1, y1;
+        getCells(area, x0, y0, x1, y1);
+
+        // huge area, faster to check everything
+        if((long long)(x1 - x0 + 1) * (y1 - y0 + 1) > (long long)bucketMask + 1) {
+            for(unsigned int i = 0; i < items.size(); i++) {
+                if(items[i].box.overlaps(area)) visit(i);
+            }
+
+            return;
+        }
+
+        for(int y = y0; y <= y1; y++) {
+            for(int x = x0; x <= x1; x++) {
+                unsigned int bucket = hashCell(x, y) & bucketMask;
+                unsigned int end = bucketStarts[bucket + 1];
+
+                unsigned int start = bucketStarts[bucket];
+
+                for(unsigned int e = start; e < end; e++) {
+                    unsigned int id = entries[e];
+
+                    // more cells of one box in the same bucket (they are next to each other)
+                    if(e > start && entries[e - 1] == id) continue;
+
+                    const Item& item = items[id];
+
+                    // other cell in the same bucket
+                    if(x < item.cellX0 || x > item.cellX1 || y < item.cellY0 || y > item.cellY1) continue;
+
+                    // box is reported only from the first cell shared with area
+                    if(x != std::max(item.cellX0, x0) || y != std::max(item.cellY0, y0)) continue;
+
+                    if(item.box.overlaps(area)) visit(id);
+                }
+            }
+        }
+
+        for(unsigned int i = 0; i < largeItems.size(); i++) {
+            if(items[largeItems[i]].box.overlaps(area)) visit(largeItems[i]);
+        }
+    }
+};
+
+#endif
@@ -99,6 +99,12 @@ public:
 	*  Draw event (to override)
 	*/
     virtual void draw();
+
+    /**
+	*  Get key of texture (loaded graphic)
+	*  @return Texture key
+	*/
+    virtual const void* getTextureKey();
 	
 	/**
 	*  Update event (to override)
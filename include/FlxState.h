@@ -13,8 +13,23 @@
 */
 class FlxState : public FlxGroup {
 
+private:
+    friend class FlxG;
+
+    // assets warmed up before background loading (see FlxG::switchStateAsync)
+    std::vector<std::string> imagesToPreload;
+    std::vector<std::pair<std::string, int> > fontsToPreload;
+    std::vector<std::string> soundsToPreload;
+    unsigned int assetsPreloaded;
 public:
 
+    /**
+	*  Default constructor
+	*/
+    FlxState() {
+        assetsPreloaded = 0;
+    }
+
     /**
 	*  Default destrurctor
 	*/
@@ -29,6 +44,49 @@ public:
     virtual void create() {
     }
 
+    /**
+	*  Background loading event. Called by <code>FlxG::switchStateAsync()</code> on worker thread
+	*  (on main thread if backend can't load assets from other threads) before <code>create()</code>.
+	*  Put heavy construction here (tilemaps, entities). Don't use scripts and other states here.
+	*  To override.
+	*/
+    virtual void load() {
+    }
+
+    /**
+	*  Is state ready to be shown? <code>FlxG::switchStateAsync()</code> swaps states when
+	*  <code>load()</code> is finished and this function returns <code>true</code>.
+	*  To override.
+	*/
+    virtual bool isReady() {
+        return true;
+    }
+
+    /**
+	*  Load image on main thread before <code>load()</code> (see <code>FlxG::switchStateAsync()</code>)
+	*  @param path Path to image file
+	*/
+    void preloadImage(const char *path) {
+        imagesToPreload.push_back(path);
+    }
+
+    /**
+	*  Load font on main thread before <code>load()</code> (see <code>FlxG::switchStateAsync()</code>)
+	*  @param path Path to font file
+	*  @param size Font size
+	*/
+    void preloadFont(const char *path, int size) {
+        fontsToPreload.push_back(std::make_pair(std::string(path), size));
+    }
+
+    /**
+	*  Load sound on main thread before <code>load()</code> (see <code>FlxG::switchStateAsync()</code>)
+	*  @param path Path to sound file
+	*/
+    void preloadSound(const char *path) {
+        soundsToPreload.push_back(path);
+    }
+
     /**
 	*  State leaving event. It's called once when state is being destroyed (but before destructor).
 	*  To override.
@@ -10,7 +10,12 @@
 #include "FlxPath.h"
 
 /**
-*  Basic map class
+*  Basic map class. Tiles are drawn by <code>FlxTile</code> members. With default insertion
+*  callback collisions with objects look up only cells under object in <code>mapData</code> and
+*  check <code>FlxTile</code> members of these cells (killed tiles and tiles without collisions
+*  are skipped, removed tiles clear their cells). Change tiles by <code>setTile()</code> and
+*  their collision properties by <code>setTileSolid()</code> and <code>setTilesProperty()</code>.
+*  Maps with custom insertion callback are checked member by member, like other groups.
 */
 class FlxTilemap : public FlxGroup {
 
@@ -103,6 +108,34 @@ public:
     */
     void setTilesProperty(int index, int flags);
 
+    /**
+    *  Make all tiles with specified ID solid or not (by default tiles from <code>firstSolid</code> are solid)
+    *  @param index Index of tiles to set
+    *  @param solid <code>true</code> if objects collide with these tiles
+    */
+    void setTileSolid(int index, bool solid);
+
+    /**
+    *  Check if tiles with specified ID are solid
+    *  @param index Index of tiles
+    *  @return <code>true</code> if objects collide with these tiles
+    */
+    bool isTileSolid(int index);
+
+    /**
+    *  Check object against cells it covers (its hitbox swept by velocity in one step when
+    *  <code>separate</code> is set). Cost depends on object's size, not on size of map.
+    *  Entity passed to callback and returned as hit is <code>FlxTile</code> member of the cell.
+    *  Cells set by <code>setTile()</code> which had no tile are described by tile owned by map
+    *  (it's overwritten by the next check).
+    *  @param object Object to check
+    *  @param separate <code>true</code> if object should be stopped (<code>collide()</code>)
+    *  @param callback Callback. See <code>FlxBasic::CollisionCallback</code>
+    *  @param hit Set to the last tile which object hit (or <code>NULL</code>)
+    *  @return <code>false</code> if map isn't loaded or it uses custom insertion callback
+    */
+    virtual bool checkObject(FlxObject *object, bool separate, const CollisionCallback& callback, FlxBasic *&hit);
+
 	/**
 	*  Find path from start to end point.
 	*  NOTE: Always returns NULL if <code>FLX_NO_PATHFINDING</code> is present
@@ -130,6 +163,26 @@ public:
 
 private:
     InsertionCallback insertionCallback;
+
+    // tiles were added as members by default callback, so cells know their tiles
+    bool defaultInsertion;
+    std::vector<FlxHandle> cellTiles;
+
+    // collision properties of tile types (types missing here use defaults)
+    struct TileType {
+        bool solid;
+        int collisionsFlags;
+    };
+
+    std::vector<TileType> tileTypes;
+    int tileWidth, tileHeight;
+
+    // cell without tile member passed to collision functions
+    FlxTile collisionTile;
+
+    TileType& getTileType(int index);
+    FlxTile* getCollisionTile(int x, int y, int type);
+    FlxTile* getCellTile(int x, int y, int type);
 };
 
 #endif
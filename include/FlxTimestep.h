@@ -0,0 +1,106 @@
+/*
+   This file is a part of "Flixel C++ port" project
+   Copyrights (c) by Michał Korman 2012
+*/
+#ifndef _FLX_TIMESTEP_H_
+#define _FLX_TIMESTEP_H_
+
+/**
+*  Fixed timestep accumulator used by main loop.<br />
+*  Limits count of updates run in single frame, so after a hitch (assets loading,
+*  script garbage collection) game doesn't fall into "spiral of death" where every frame
+*  is late because previous one was running too many updates.
+*/
+class FlxTimestep {
+
+public:
+
+    /**
+    *  What to do with simulation time which couldn't be updated in current frame
+    */
+    enum CatchUpPolicy {
+
+        /**
+        *  Drop late time immediately. Game stays synchronized with real time.
+        */
+        DROP_TIME,
+
+        /**
+        *  Keep late time (up to <code>maxSubsteps</code> updates) and catch up in next frames.
+        *  Game runs slower for a moment, but no simulation time is lost after small hitches.
+        */
+        SLOW_TIME
+    };
+
+    /**
+    *  Maximum count of updates in single frame (0 = no limit). Default: 10
+    */
+    unsigned int maxSubsteps;
+
+    /**
+    *  Maximum length of single frame in seconds (longer frames are clamped). Default: 0.25
+    */
+    float maxFrameTime;
+
+    /**
+    *  Catch up policy. Default: <code>DROP_TIME</code>
+    */
+    CatchUpPolicy policy;
+
+    /**
+    *  Simulation time waiting for update (in seconds)
+    */
+    double accumulator;
+
+    /**
+    *  Count of updates run in last frame
+    */
+    unsigned int lastSubsteps;
+
+    /**
+    *  Total simulation time dropped by limits (in seconds)
+    */
+    double droppedTime;
+
+    /**
+    *  Total count of dropped updates
+    */
+    unsigned long long droppedSteps;
+
+    /**
+    *  Count of frames which hit updates limit
+    */
+    unsigned int lateFrames;
+
+    /**
+    *  Default constructor
+    */
+    FlxTimestep();
+
+    /**
+    *  Add frame time to accumulator and calculate how many updates should be run now
+    *  @param elapsed Real time since last frame (in seconds)
+    *  @param step Length of single update (in seconds)
+    *  @return Count of updates to run
+    */
+    unsigned int advance(float elapsed, float step);
+
+    /**
+    *  Get part of update which is still waiting in accumulator
+    *  @param step Length of single update (in seconds)
+    *  @return Value from 0 to 1
+    */
+    float getAlpha(float step);
+
+    /**
+    *  Clear accumulator (e.g. before entering new main loop)
+    */
+    void reset();
+
+    /**
+    *  Clear dropped time counters
+    */
+    void resetStats();
+};
+
+#endif
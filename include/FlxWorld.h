@@ -0,0 +1,307 @@
+/*
+   This file is a part of "Flixel C++ port" project
+   Copyrights (c) by Michał Korman 2012
+*/
+#ifndef _FLX_WORLD_H_
+#define _FLX_WORLD_H_
+
+#include "backend/cpp.h"
+#include "FlxObject.h"
+#include "FlxBackendBase.h"
+
+/**
+*  Entity of <code>FlxWorld</code> (index and generation, so destroyed entities are detected)
+*/
+typedef unsigned int FlxEntity;
+
+/**
+*  Invalid entity
+*/
+#define FLX_NO_ENTITY 0xFFFFFFFF
+
+/**
+*  Components flags (entity's components are combination of these)
+*/
+enum FlxComponent {
+    FLX_TRANSFORM = 1,
+    FLX_VELOCITY = 2,
+    FLX_HITBOX = 4,
+    FLX_SPRITE = 8,
+    FLX_ANIMATION = 16
+};
+
+
+/**
+*  Position and rotation
+*/
+struct FlxTransform {
+    enum { ID = FLX_TRANSFORM };
+
+    float x, y, angle;
+
+    /**
+    *  Position before last motion step (used by render interpolation)
+    */
+    float lastX, lastY;
+
+    FlxTransform() : x(0), y(0), angle(0), lastX(0), lastY(0) { }
+};
+
+
+/**
+*  Motion (the same rules as in <code>FlxObject::update()</code>)
+*/
+struct FlxVelocity {
+    enum { ID = FLX_VELOCITY };
+
+    FlxVector velocity, acceleration, maxVelocity;
+    float angularVelocity;
+
+    FlxVelocity() : maxVelocity(1000.f, 1000.f), angularVelocity(0) { }
+};
+
+
+/**
+*  Collision box (moved with transform)
+*/
+struct FlxHitbox {
+    enum { ID = FLX_HITBOX };
+
+    FlxRect rect;
+    FlxVector offset;
+};
+
+
+/**
+*  Image drawn at entity's position
+*/
+struct FlxSpriteRef {
+    enum { ID = FLX_SPRITE };
+
+    FlxBackendImage *image;
+
+    /**
+    *  Part of image to draw (width and height are frame size)
+    */
+    FlxRect source;
+
+    FlxVector scale;
+    int color;
+    float alpha;
+    bool visible;
+
+    FlxSpriteRef() : image(NULL), scale(1.f, 1.f), color(0xffffff), alpha(1.f), visible(true) { }
+};
+
+
+/**
+*  Frames animation (frames are consecutive tiles of sprite's image)
+*/
+struct FlxAnimation {
+    enum { ID = FLX_ANIMATION };
+
+    unsigned int firstFrame, framesCount, currentFrame;
+    float frameTime, counter;
+    bool looped, finished;
+
+    FlxAnimation() : firstFrame(0), framesCount(1), currentFrame(0), frameTime(0.1f), counter(0),
+                     looped(true), finished(false) { }
+};
+
+
+/**
+*  Dense block of entities with the same components. Arrays of components which entities
+*  don't have are <code>NULL</code>.
+*/
+struct FlxWorldChunk {
+    unsigned int components;
+    unsigned int count;
+
+    FlxEntity *entities;
+    FlxTransform *transforms;
+    FlxVelocity *velocities;
+    FlxHitbox *hitboxes;
+    FlxSpriteRef *sprites;
+    FlxAnimation *animations;
+
+    /**
+    *  Get array of components
+    *  @return Array of <code>count</code> components or <code>NULL</code>
+    */
+    template<class T> T* get();
+};
+
+template<> inline FlxTransform* FlxWorldChunk::get<FlxTransform>() { return transforms; }
+template<> inline FlxVelocity* FlxWorldChunk::get<FlxVelocity>() { return velocities; }
+template<> inline FlxHitbox* FlxWorldChunk::get<FlxHitbox>() { return hitboxes; }
+template<> inline FlxSpriteRef* FlxWorldChunk::get<FlxSpriteRef>() { return sprites; }
+template<> inline FlxAnimation* FlxWorldChunk::get<FlxAnimation>() { return animations; }
+
+
+/**
+*  Data-oriented entities world.<br />
+*  Entities are plain ids, their components live in archetype chunks (entities with the same
+*  components are stored together in dense arrays), so systems iterate arrays instead of chasing
+*  pointers and calling virtual functions. Built-in systems move entities, update hitboxes and
+*  animations and draw sprites in batches. Custom systems are functions called per chunk.<br />
+*  World is a single object of state, so hot entity types can be moved from <code>FlxSprite</code>
+*  subclasses to components one at a time.
+*/
+class FlxWorld : public FlxObject {
+
+public:
+
+    /**
+    *  System function (called for every chunk which has required components)
+    */
+    typedef std::function<void(FlxWorldChunk& chunk)> System;
+
+private:
+    struct Chunk;
+    struct Archetype;
+
+    struct Record {
+        Chunk *chunk;
+        unsigned int row;
+        unsigned int generation;
+    };
+
+    struct SystemEntry {
+        unsigned int components;
+        System system;
+    };
+
+    std::map<unsigned int, Archetype*> archetypes;
+    std::vector<Archetype*> archetypesList;
+    std::vector<Record> records;
+    std::vector<unsigned int> freeIndices;
+    std::vector<FlxEntity> destroyQueue;
+    std::vector<SystemEntry> systems;
+    std::vector<FlxBatchSprite> batch;
+    FlxBackendImage *batchImage;
+    FlxVector batchScale;
+    int batchColor;
+    float batchAlpha;
+    unsigned int entitiesCount;
+    unsigned int iterating;
+    unsigned int lastWorldUpdate;
+
+    Archetype* getArchetype(unsigned int components);
+    Record* getRecord(FlxEntity entity);
+    FlxWorldChunk* getChunk(Record *record);
+    void insert(FlxEntity entity, Archetype *archetype);
+    void removeRow(Chunk *chunk, unsigned int row);
+    void erase(FlxEntity entity);
+    void flushDestroyed();
+    void flushBatch();
+
+    void updateMotion(FlxWorldChunk& chunk, float dt);
+    void updateHitboxes(FlxWorldChunk& chunk);
+    void updateAnimations(FlxWorldChunk& chunk, float dt);
+    void drawSprites(FlxWorldChunk& chunk, const FlxVector& move, bool interpolate);
+public:
+
+    /**
+    *  Default constructor
+    */
+    FlxWorld();
+
+    /**
+    *  Destructor, destroys all entities
+    */
+    virtual ~FlxWorld();
+
+    /**
+    *  Create entity
+    *  @param components Combination of <code>FlxComponent</code> flags
+    *  @return New entity (components have default values)
+    */
+    FlxEntity create(unsigned int components);
+
+    /**
+    *  Destroy entity. Inside <code>forEach()</code> and systems entity is destroyed after iteration
+    *  (rows of chunks don't move while they are iterated).
+    *  @param entity Entity to destroy
+    */
+    void destroy(FlxEntity entity);
+
+    /**
+    *  Is entity alive?
+    *  @param entity Entity to check
+    *  @return <code>true</code> if entity exists
+    */
+    bool isAlive(FlxEntity entity);
+
+    /**
+    *  Get entity's components
+    *  @param entity Entity
+    *  @return Combination of <code>FlxComponent</code> flags (0 for dead entities)
+    */
+    unsigned int getComponents(FlxEntity entity);
+
+    /**
+    *  Add or remove components (entity is moved to other archetype, common components are kept).
+    *  NOTE: Don't call it inside <code>forEach()</code> or systems.
+    *  @param entity Entity
+    *  @param components New combination of <code>FlxComponent</code> flags
+    */
+    void setComponents(FlxEntity entity, unsigned int components);
+
+    /**
+    *  Get entity's component. Pointer is valid until entities are created, destroyed or changed.
+    *  @param entity Entity
+    *  @return Component or <code>NULL</code> if entity doesn't have it
+    */
+    template<class T> T* get(FlxEntity entity) {
+        Record *record = getRecord(entity);
+        if(!record) return NULL;
+
+        T *array = getChunk(record)->template get<T>();
+        return array ? &array[record->row] : NULL;
+    }
+
+    /**
+    *  Get count of alive entities
+    *  @return Entities count
+    */
+    unsigned int getEntitiesCount();
+
+    /**
+    *  Destroy all entities
+    */
+    void clear();
+
+    /**
+    *  Call function for every chunk which has all specified components. Entities created
+    *  inside may be visited in the same pass.
+    *  @param components Required components
+    *  @param function Function to call
+    */
+    void forEach(unsigned int components, const System& function);
+
+    /**
+    *  Register system called every update (after built-in motion, hitbox and animation systems)
+    *  @param components Required components
+    *  @param system System function
+    */
+    void addSystem(unsigned int components, const System& system);
+
+    /**
+    *  Find entities which hitboxes overlap rectangle
+    *  @param rect Rectangle to check
+    *  @param result Found entities are appended here
+    */
+    void query(const FlxRect& rect, std::vector<FlxEntity>& result);
+
+    /**
+    *  Run all systems
+    */
+    virtual void update();
+
+    /**
+    *  Draw all visible sprites
+    */
+    virtual void draw();
+};
+
+#endif
@@ -9,6 +9,13 @@
 #define COLOR_GET_G(hex) ((hex >> 8) & 0xFF)
 #define COLOR_GET_B(hex) ((hex) & 0xFF)
 
+// thread local variables (not every supported compiler knows thread_local keyword)
+#ifdef _MSC_VER
+    #define FLX_THREAD_LOCAL __declspec(thread)
+#else
+    #define FLX_THREAD_LOCAL __thread
+#endif
+
 #include <iostream>
 #include <string>
 #include <vector>
@@ -26,5 +33,49 @@
 
 #include <initializer_list>
 #include <functional>
+#include <atomic>
+
+// threads support (FLX_NO_THREADS for toolchains without std::thread, e.g. old Android NDK)
+#if defined(_MSC_VER) && _MSC_VER < 1700 && !defined(FLX_NO_THREADS)
+    #define FLX_NO_THREADS
+#endif
+
+#ifndef FLX_NO_THREADS
+    #include <thread>
+    #include <mutex>
+    #include <condition_variable>
+
+    typedef std::mutex FlxMutex;
+    typedef std::lock_guard<std::mutex> FlxLock;
+#else
+    class FlxMutex {
+    public:
+        void lock() { }
+        void unlock() { }
+    };
+
+    class FlxLock {
+    public:
+        FlxLock(FlxMutex& mutex) { (void)mutex; }
+    };
+#endif
+
+// SSE intrinsics (FLX_NO_SIMD forces scalar code)
+#if !defined(FLX_NO_SIMD) && (defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1))
+    #define FLX_SSE
+    #include <xmmintrin.h>
+#endif
+
+// AVX kernels need compiler which can build single function for AVX (selected at runtime)
+#if defined(FLX_SSE) && ((defined(_MSC_VER) && _MSC_VER >= 1600) || defined(__clang__) || \
+    (defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+    #define FLX_AVX
+
+    #ifdef _MSC_VER
+        #define FLX_AVX_FUNCTION
+    #else
+        #define FLX_AVX_FUNCTION __attribute__((target("avx")))
+    #endif
+#endif
 
 #endif
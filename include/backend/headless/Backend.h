@@ -0,0 +1,188 @@
+/*
+   This file is a part of "Flixel C++ port" project
+   Copyrights (c) by Michał Korman 2012
+*/
+#ifndef _FLX_BACKEND_HEADLESS_H_
+#define _FLX_BACKEND_HEADLESS_H_
+
+#include "../../FlxBackendBase.h"
+
+/*
+*  Rendering statistics collected by headless backend
+*/
+struct Headless_Stats {
+    unsigned int frames;
+    unsigned long long updates;
+    unsigned long long drawCalls;
+    unsigned long long textDraws;
+    unsigned long long shaderDraws;
+    unsigned long long textureSwitches;
+    unsigned long long bytesUploaded;
+
+    // time spent in update/draw callbacks (in nanoseconds)
+    unsigned long long updateTime;
+    unsigned long long drawTime;
+};
+
+
+/*
+*  Headless (null) renderer.
+*  Doesn't need any window, GPU or audio device. Images, fonts and sounds are
+*  metadata-only handles, files are kept in memory and main loop runs as fast as possible.
+*  Useful for profiling and soak tests on build machines.
+*/
+class Headless_Backend : public FlxBackendBase {
+
+public:
+
+    /*
+    *  Called after every rendered frame
+    */
+    typedef std::function<void(Headless_Backend*)> FrameCallback;
+
+private:
+    int width, height;
+    unsigned int maxFrames;
+    std::atomic<unsigned int> frame;
+    float frameTime;
+    double currentTime;
+    float soundLength;
+    int defaultImageWidth, defaultImageHeight;
+
+    bool keysDown[1024];
+    bool mouseButtons[3];
+    FlxVector mousePosition;
+
+    std::map<std::string, FlxBackendImage*> images;
+    std::map<std::string, std::pair<int, int> > imageSizes;
+    std::map<std::string, void*> fonts;
+    std::map<std::string, void*> sounds;
+    std::map<std::string, std::string> files;
+    std::vector<FlxBackendImage*> createdImages;
+    std::vector<FlxBackendShader*> shaders;
+
+    // assets can be loaded by background state loading
+    FlxMutex assetsMutex;
+
+    void *lastTexture;
+    Headless_Stats frameStats, totalStats, lastStats;
+    unsigned long long drawStart;
+
+    // counted on main thread, merged into statistics when frame is rendered (maybe on render thread)
+    std::atomic<unsigned long long> frameStart, pendingUpdates, pendingUploads;
+    FrameCallback frameCallback;
+
+    bool readImageSize(const char *path, int &w, int &h);
+    std::string* findFile(const char *path, const char *mode);
+    void bindTexture(void *texture);
+public:
+    Headless_Backend(unsigned int maxFrames = 0);
+    virtual std::string getName() { return "Headless"; }
+
+    virtual bool setupSurface(const char *title, int width, int height, const char *icon);
+    virtual void mainLoop(void (*onUpdate)(), void (*onDraw)());
+    virtual FlxVector getScreenSize();
+    virtual void exitApplication();
+    virtual bool* getKeysDown();
+    virtual bool isKeyDown(int code);
+    virtual FlxVector getMousePosition(int index);
+    virtual bool getMouseButtonState(int button, int index);
+    virtual void showMouse(bool show);
+
+    virtual void drawImage(FlxBackendImage *img, float x, float y,  const FlxVector& scale, float angle,
+                           const FlxRect& source, int color, bool flipped, float alpha);
+    virtual void drawImages(FlxBackendImage *img, const FlxBatchSprite *sprites, unsigned int count,
+                            const FlxVector& scale, int color, float alpha);
+
+    virtual FlxBaseText *createText(const wchar_t *text, void *font, int size, int color, float alpha);
+    virtual void destroyText(FlxBaseText *data);
+    virtual void drawText(FlxBaseText *text, float x, float y, const FlxVector& scale,
+                                    float angle);
+
+    virtual FlxBackendImage* createImage(int width, int height, int color, float alpha);
+    virtual FlxBackendImage *loadImage(const char *path);
+    virtual bool isAsyncLoadingSupported() { return true; }
+
+    virtual bool isShadersSupported();
+    virtual FlxBackendShader* loadShader(const char *path);
+    virtual void drawShader(FlxBackendShader *shader);
+    virtual bool isRenderThreadSupported() { return true; }
+
+    virtual void *loadFont(const char *path, int fontSize);
+
+    virtual void* loadSound(const char *path);
+    virtual FlxBackendMusic* loadMusic(const char *path);
+    virtual FlxBackendSound* createSound();
+    virtual void playMusic(FlxBackendMusic *music, float vol);
+
+    virtual FlxBackendFile* openFile(const char *path, const char *mode, bool internal);
+
+    virtual bool sendHttpRequest(FlxHttpRequest *req, FlxHttpResponse& resp);
+
+    virtual bool isRunning();
+    virtual double getTime();
+    virtual void beginFrame();
+    virtual void updateEvents();
+    virtual void beginDraw();
+    virtual void endDraw();
+
+
+    // headless specific stuff
+
+    /*
+    *  Stop main loop after specified frames count (0 = run until FlxG::exitMessage)
+    */
+    void setMaxFrames(unsigned int frames);
+
+    /*
+    *  Simulated duration of single frame in seconds (0 = FlxG::fixedTime).
+    *  getTime() returns simulated time since setupSurface().
+    */
+    void setFrameTime(float seconds);
+
+    /*
+    *  Size of images which couldn't be found or which aren't PNG files
+    */
+    void setDefaultImageSize(int width, int height);
+
+    /*
+    *  Force size of image loaded from specified path
+    */
+    void registerImage(const char *path, int width, int height);
+
+    /*
+    *  How long every sound "plays" (in simulated seconds)
+    */
+    void setSoundLength(float seconds);
+
+    /*
+    *  Put file into in-memory filesystem
+    */
+    void addFile(const char *path, const std::string& data);
+
+    /*
+    *  Get file from in-memory filesystem
+    */
+    bool getFile(const char *path, std::string& data);
+
+    /*
+    *  Input simulation
+    */
+    void setKeyDown(int code, bool down);
+    void setMousePosition(float x, float y);
+    void setMouseButton(int button, bool down);
+
+    /*
+    *  Statistics (updated when frame is rendered, so with render thread read them in frame callback)
+    */
+    const Headless_Stats& getFrameStats() const { return frameStats; }
+    const Headless_Stats& getTotalStats() const { return totalStats; }
+    void resetStats();
+
+    /*
+    *  Set callback called after every frame (on render thread, if it's running)
+    */
+    void setFrameCallback(const FrameCallback& callback);
+};
+
+#endif
@@ -32,13 +32,11 @@ private:
 	unsigned int framebuffer;
 	int screenWidth;
 	int screenHeight;
-	
-    void updateEvents();
+	int soundChannels;
 public:
 	virtual std::string getName() { return "SDL2/mobile"; }
 	
     virtual bool setupSurface(const char *title, int width, int height, const char *icon);
-    virtual void mainLoop(void (*onUpdate)(), void (*onDraw)());
     virtual FlxVector getScreenSize();
     virtual void exitApplication();
     virtual bool* getKeysDown();
@@ -65,12 +63,18 @@ public:
 
     virtual void* loadSound(const char *path);
     virtual FlxBackendMusic* loadMusic(const char *path);
-    virtual FlxBackendSound* playSound(void *sound, float vol);
+    virtual FlxBackendSound* createSound();
     virtual void playMusic(FlxBackendMusic *music, float vol);
 
     virtual FlxBackendFile* openFile(const char *path, const char *mode, bool internal);
 	
 	virtual bool sendHttpRequest(FlxHttpRequest *req, FlxHttpResponse& resp);
+
+    virtual bool isRunning();
+    virtual double getTime();
+    virtual void updateEvents();
+    virtual void beginDraw();
+    virtual void endDraw();
 };
 
 #endif
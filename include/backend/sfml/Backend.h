@@ -31,13 +31,14 @@ private:
 
     GLuint framebuffer;
 
-    void updateEvents();
+    // vertex data of batched draw calls (reused every frame)
+    std::vector<float> batchVertices, batchTexCoords;
+    std::vector<unsigned char> batchColors;
 public:
     SFML_Backend(bool fullscreen = false);
     virtual std::string getName() { return "SFML"; }
 
     virtual bool setupSurface(const char *title, int width, int height, const char *icon);
-    virtual void mainLoop(void (*onUpdate)(), void (*onDraw)());
     virtual FlxVector getScreenSize();
     virtual void exitApplication();
     virtual bool* getKeysDown();
@@ -48,6 +49,8 @@ public:
 
     virtual void drawImage(FlxBackendImage *img, float x, float y,  const FlxVector& scale, float angle,
                            const FlxRect& source, int color, bool flipped, float alpha);
+    virtual void drawImages(FlxBackendImage *img, const FlxBatchSprite *sprites, unsigned int count,
+                            const FlxVector& scale, int color, float alpha);
 
     virtual FlxBaseText *createText(const wchar_t *text, void *font, int size, int color, float alpha);
     virtual void destroyText(FlxBaseText *data);
@@ -65,12 +68,18 @@ public:
 
     virtual void* loadSound(const char *path);
     virtual FlxBackendMusic* loadMusic(const char *path);
-    virtual FlxBackendSound* playSound(void *sound, float vol);
+    virtual FlxBackendSound* createSound();
     virtual void playMusic(FlxBackendMusic *music, float vol);
 
     virtual FlxBackendFile* openFile(const char *path, const char *mode, bool internal);
 
     virtual bool sendHttpRequest(FlxHttpRequest *req, FlxHttpResponse& resp);
+
+    virtual bool isRunning();
+    virtual double getTime();
+    virtual void updateEvents();
+    virtual void beginDraw();
+    virtual void endDraw();
 };
 
 #endif
@@ -0,0 +1,56 @@
+#include "FlxBackendBase.h"
+#include "FlxG.h"
+#include <chrono>
+
+void FlxBackendBase::mainLoop(void (*onUpdate)(), void (*onDraw)()) {
+
+    double currentTime = getTime();
+    FlxG::timestep.reset();
+
+    while(isRunning() && !FlxG::exitMessage) {
+
+        beginFrame();
+
+        // things scheduled by jobs for main thread
+        FlxG::jobs.update();
+
+        // fixed timestep stuff
+        double newTime = getTime();
+        float elapsed = (float)(newTime - currentTime);
+        currentTime = newTime;
+
+        unsigned int steps = FlxG::timestep.advance(elapsed, FlxG::fixedTime);
+
+        for(unsigned int i = 0; i < steps; i++) {
+
+            // update all stuff
+            updateEvents();
+            onUpdate();
+        }
+
+        // render
+        FlxG::interpolationAlpha = FlxG::timestep.getAlpha(FlxG::fixedTime);
+
+        FlxG::renderer.beginFrame();
+        onDraw();
+        FlxG::renderer.endFrame();
+
+        FlxG::elapsed = elapsed;
+    }
+}
+
+
+double FlxBackendBase::getTime() {
+    static std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+
+void FlxBackendBase::drawImages(FlxBackendImage *img, const FlxBatchSprite *sprites, unsigned int count,
+                                const FlxVector& scale, int color, float alpha)
+{
+    for(unsigned int i = 0; i < count; i++) {
+        drawImage(img, sprites[i].x, sprites[i].y, scale, sprites[i].angle, sprites[i].source,
+                  color, false, alpha);
+    }
+}
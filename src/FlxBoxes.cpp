@@ -0,0 +1,222 @@
+#include "FlxBoxes.h"
+#include "FlxKinematics.h"
+#include <limits>
+
+#ifdef FLX_AVX
+    #include <immintrin.h>
+#endif
+
+// arrays are padded to the widest kernel (8 floats) and aligned to 32 bytes
+static const unsigned int Padding = 8;
+
+// padding lanes never overlap anything
+static const float Empty = std::numeric_limits<float>::infinity();
+
+
+static unsigned int roundUp(unsigned int value) {
+    return (value + Padding - 1) / Padding * Padding;
+}
+
+
+static unsigned int countBits(unsigned int bits) {
+    unsigned int result = 0;
+
+    for(; bits != 0; bits &= bits - 1) {
+        result++;
+    }
+
+    return result;
+}
+
+
+FlxBoxes::FlxBoxes() {
+    storage = NULL;
+    minX = minY = maxX = maxY = NULL;
+    count = capacity = 0;
+}
+
+
+FlxBoxes::~FlxBoxes() {
+    delete[] storage;
+}
+
+
+void FlxBoxes::clear() {
+    for(unsigned int i = 0; i < roundUp(count); i++) {
+        minX[i] = minY[i] = Empty;
+        maxX[i] = maxY[i] = -Empty;
+    }
+
+    count = 0;
+}
+
+
+void FlxBoxes::reserve(unsigned int boxes) {
+    if(boxes <= capacity) return;
+
+    unsigned int newCapacity = roundUp(boxes);
+    float *newStorage = new float[newCapacity * 4 + Padding];
+    float *base = (float*)(((size_t)newStorage + 31) & ~(size_t)31);
+
+    float *arrays[4] = { base, base + newCapacity, base + newCapacity * 2, base + newCapacity * 3 };
+    float *old[4] = { minX, minY, maxX, maxY };
+
+    for(int a = 0; a < 4; a++) {
+        float empty = (a < 2) ? Empty : -Empty;
+
+        for(unsigned int i = 0; i < newCapacity; i++) {
+            arrays[a][i] = (i < count) ? old[a][i] : empty;
+        }
+    }
+
+    delete[] storage;
+    storage = newStorage;
+    minX = arrays[0];
+    minY = arrays[1];
+    maxX = arrays[2];
+    maxY = arrays[3];
+    capacity = newCapacity;
+}
+
+
+unsigned int FlxBoxes::add(const FlxBox& box) {
+    if(count == capacity) reserve(capacity < 64 ? 64 : capacity * 2);
+
+    set(count, box);
+    return count++;
+}
+
+
+static void queryScalar(const float * const *arrays, const FlxBox& area, unsigned int first, unsigned int boxes,
+                        unsigned int *masks, bool touching)
+{
+    const float *minX = arrays[0] + first, *minY = arrays[1] + first;
+    const float *maxX = arrays[2] + first, *maxY = arrays[3] + first;
+
+    for(unsigned int i = 0; i < boxes; i++) {
+        bool hit;
+
+        if(touching) {
+            hit = minX[i] <= area.maxX && area.minX <= maxX[i] && minY[i] <= area.maxY && area.minY <= maxY[i];
+        }
+        else {
+            hit = minX[i] < area.maxX && area.minX < maxX[i] && minY[i] < area.maxY && area.minY < maxY[i];
+        }
+
+        if(hit) masks[i / 32] |= 1u << (i % 32);
+    }
+}
+
+
+#ifdef FLX_SSE
+static void querySse(const float * const *arrays, const FlxBox& area, unsigned int first, unsigned int boxes,
+                     unsigned int *masks, bool touching)
+{
+    __m128 areaMinX = _mm_set1_ps(area.minX), areaMinY = _mm_set1_ps(area.minY);
+    __m128 areaMaxX = _mm_set1_ps(area.maxX), areaMaxY = _mm_set1_ps(area.maxY);
+
+    for(unsigned int i = 0; i < boxes; i += 4) {
+        __m128 minX = _mm_load_ps(arrays[0] + first + i);
+        __m128 minY = _mm_load_ps(arrays[1] + first + i);
+        __m128 maxX = _mm_load_ps(arrays[2] + first + i);
+        __m128 maxY = _mm_load_ps(arrays[3] + first + i);
+        __m128 hit;
+
+        if(touching) {
+            hit = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(minX, areaMaxX), _mm_cmple_ps(areaMinX, maxX)),
+                             _mm_and_ps(_mm_cmple_ps(minY, areaMaxY), _mm_cmple_ps(areaMinY, maxY)));
+        }
+        else {
+            hit = _mm_and_ps(_mm_and_ps(_mm_cmplt_ps(minX, areaMaxX), _mm_cmplt_ps(areaMinX, maxX)),
+                             _mm_and_ps(_mm_cmplt_ps(minY, areaMaxY), _mm_cmplt_ps(areaMinY, maxY)));
+        }
+
+        masks[i / 32] |= (unsigned int)_mm_movemask_ps(hit) << (i % 32);
+    }
+}
+#endif
+
+
+#ifdef FLX_AVX
+FLX_AVX_FUNCTION static void queryAvx(const float * const *arrays, const FlxBox& area, unsigned int first,
+                                      unsigned int boxes, unsigned int *masks, bool touching)
+{
+    __m256 areaMinX = _mm256_set1_ps(area.minX), areaMinY = _mm256_set1_ps(area.minY);
+    __m256 areaMaxX = _mm256_set1_ps(area.maxX), areaMaxY = _mm256_set1_ps(area.maxY);
+
+    for(unsigned int i = 0; i < boxes; i += 8) {
+        __m256 minX = _mm256_load_ps(arrays[0] + first + i);
+        __m256 minY = _mm256_load_ps(arrays[1] + first + i);
+        __m256 maxX = _mm256_load_ps(arrays[2] + first + i);
+        __m256 maxY = _mm256_load_ps(arrays[3] + first + i);
+        __m256 hitX, hitY;
+
+        // ordered, non-signaling comparisons (the same as <= and < in scalar code)
+        if(touching) {
+            hitX = _mm256_and_ps(_mm256_cmp_ps(minX, areaMaxX, _CMP_LE_OQ), _mm256_cmp_ps(areaMinX, maxX, _CMP_LE_OQ));
+            hitY = _mm256_and_ps(_mm256_cmp_ps(minY, areaMaxY, _CMP_LE_OQ), _mm256_cmp_ps(areaMinY, maxY, _CMP_LE_OQ));
+        }
+        else {
+            hitX = _mm256_and_ps(_mm256_cmp_ps(minX, areaMaxX, _CMP_LT_OQ), _mm256_cmp_ps(areaMinX, maxX, _CMP_LT_OQ));
+            hitY = _mm256_and_ps(_mm256_cmp_ps(minY, areaMaxY, _CMP_LT_OQ), _mm256_cmp_ps(areaMinY, maxY, _CMP_LT_OQ));
+        }
+
+        masks[i / 32] |= (unsigned int)_mm256_movemask_ps(_mm256_and_ps(hitX, hitY)) << (i % 32);
+    }
+
+    _mm256_zeroupper();
+}
+#endif
+
+
+unsigned int FlxBoxes::query(const FlxBox& area, unsigned int first, unsigned int boxes, unsigned int *masks,
+                             bool touching) const
+{
+    unsigned int words = getMaskWords(boxes);
+
+    for(unsigned int w = 0; w < words; w++) {
+        masks[w] = 0;
+    }
+
+    if(first >= count || boxes == 0) return 0;
+    if(boxes > count - first) boxes = count - first;
+
+    const float *arrays[4] = { minX, minY, maxX, maxY };
+    FlxKinematics::Kernel kernel = FlxKinematics::getKernel();
+
+    // padded lanes are tested too (arrays are padded, lanes after the last box are empty)
+    #ifdef FLX_AVX
+    if(kernel == FlxKinematics::AVX) queryAvx(arrays, area, first, roundUp(boxes), masks, touching);
+    else
+    #endif
+    #ifdef FLX_SSE
+    if(kernel == FlxKinematics::SSE) querySse(arrays, area, first, roundUp(boxes), masks, touching);
+    else
+    #endif
+    queryScalar(arrays, area, first, boxes, masks, touching);
+
+    (void)kernel;
+
+    // lanes after range (when it ends before the last box)
+    if(boxes % 32 != 0) masks[getMaskWords(boxes) - 1] &= (1u << (boxes % 32)) - 1;
+
+    unsigned int hits = 0;
+
+    for(unsigned int w = 0; w < words; w++) {
+        hits += countBits(masks[w]);
+    }
+
+    return hits;
+}
+
+
+unsigned int FlxBoxes::query(const FlxBoxes& areas, unsigned int *masks, bool touching) const {
+    unsigned int words = getMaskWords(count);
+    unsigned int hits = 0;
+
+    for(unsigned int i = 0; i < areas.size(); i++) {
+        hits += query(areas.getBox(i), 0, count, masks + i * words, touching);
+    }
+
+    return hits;
+}
@@ -1,6 +1,12 @@
 #include "FlxEmitter.h"
+#include "FlxProfiler.h"
 #include "FlxG.h"
 
+#ifdef FLX_SSE
+// count of set bits in 4-bit mask
+static const unsigned int MaskBits[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+#endif
+
 // Default particles insertion callback. May be replaced with your own,
 // for example inserting Box2D bodies.
 extern void FlxDefaultParticleCallback(FlxEmitter *emitter, FlxParticle *particle) {
@@ -22,6 +28,14 @@ FlxEmitter::FlxEmitter(float X, float Y, const FlxVector &speedRangeX, const Flx
     particleHeight = 0;
     particleTiles = 0;
     timeToLife = lifeTime;
+    gravity = 0;
+
+    capacity = usedSlots = nextSlot = liveParticles = 0;
+    lastBatchUpdate = 0;
+    graphic = NULL;
+
+    // order of particles doesn't matter
+    compactionMode = FLX_COMPACT_SWAP;
 
     if(callback == nullptr) {
         insertionCallback = FlxDefaultParticleCallback;
@@ -54,6 +68,11 @@ void FlxEmitter::atCenter(FlxObject *obj) {
 
 void FlxEmitter::emit(int howMany) {
 
+    if(capacity > 0) {
+        emitBatched(howMany);
+        return;
+    }
+
     for(int i = 0; i < howMany; i++) {
         FlxParticle *part = new FlxParticle(x, y, tileset.c_str(), particleWidth, particleHeight,
                                             FlxU::random(0, particleTiles));
@@ -78,14 +97,183 @@ void FlxEmitter::loadGraphic(const char *Tileset, int Width, int Height, int Til
     particleWidth = Width;
     particleHeight = Height;
     particleTiles = TileTypes;
+
+    // batched particles load it on next emit
+    graphic = NULL;
+    frames.clear();
+}
+
+
+void FlxEmitter::setBatched(unsigned int maxParticles) {
+    capacity = maxParticles;
+    usedSlots = nextSlot = liveParticles = 0;
+
+    // padded to SIMD width, padding slots are always dead
+    unsigned int slots = (maxParticles + 3) & ~3u;
+
+    particleX.assign(slots, 0.f);
+    particleY.assign(slots, 0.f);
+    particleVelocityX.assign(slots, 0.f);
+    particleVelocityY.assign(slots, 0.f);
+    particleLife.assign(slots, 0.f);
+    particleAngle.assign(slots, 0.f);
+    particleFrame.assign(slots, 0);
+    batch.resize(slots);
+}
+
+
+bool FlxEmitter::isBatched() {
+    return capacity > 0;
+}
+
+
+unsigned int FlxEmitter::getParticlesCount() {
+    return (capacity > 0) ? liveParticles : size();
+}
+
+
+void FlxEmitter::loadFrames() {
+    if(tileset.empty()) return;
+
+    graphic = FlxG::backend->loadImage(tileset.c_str());
+    if(!graphic) return;
+
+    int w = (particleWidth == 0) ? graphic->getWidth() : particleWidth;
+    int h = (particleHeight == 0) ? graphic->getHeight() : particleHeight;
+    int tiles = (particleTiles > 0) ? particleTiles : 1;
+
+    // the same layout as in FlxSprite::calcFrame()
+    frames.clear();
+
+    for(int i = 0; i < tiles; i++) {
+        int rx = i * w, ry = 0;
+
+        if(rx >= graphic->getWidth()) {
+            ry = (rx / graphic->getWidth()) * h;
+            rx %= graphic->getWidth();
+        }
+
+        frames.push_back(FlxRect((float)rx, (float)ry, (float)w, (float)h));
+    }
+}
+
+
+void FlxEmitter::emitBatched(int howMany) {
+    if(!graphic) loadFrames();
+
+    bool mortal = timeToLife.x > 0 && timeToLife.y > 0;
+    int lastFrame = frames.empty() ? 0 : (int)frames.size() - 1;
+
+    for(int i = 0; i < howMany; i++) {
+        unsigned int slot = nextSlot;
+        nextSlot = (nextSlot + 1) % capacity;
+
+        if(slot >= usedSlots) usedSlots = slot + 1;
+        if(particleLife[slot] <= 0) liveParticles++;
+
+        particleX[slot] = x;
+        particleY[slot] = y;
+        particleAngle[slot] = FlxU::random(particleRotation.x, particleRotation.y);
+        particleVelocityX[slot] = FlxU::random(particleSpeedX.x, particleSpeedX.y);
+        particleVelocityY[slot] = FlxU::random(particleSpeedY.x, particleSpeedY.y);
+        particleLife[slot] = mortal ? FlxU::random(timeToLife.x, timeToLife.y) : std::numeric_limits<float>::infinity();
+        particleFrame[slot] = (unsigned short)FlxU::random(0, lastFrame);
+    }
+}
+
+
+void FlxEmitter::updateBatched() {
+    FLX_PROFILE_ZONE("FlxEmitter::updateBatched");
+
+    float dt = FlxG::fixedTime;
+    float dv = gravity * dt;
+
+    // dead particles are moved too, it's cheaper than skipping them
+    unsigned int count = (usedSlots + 3) & ~3u;
+    unsigned int i = 0, live = 0;
+
+    float *px = particleX.empty() ? NULL : &particleX[0];
+    float *py = particleY.empty() ? NULL : &particleY[0];
+    float *vx = particleVelocityX.empty() ? NULL : &particleVelocityX[0];
+    float *vy = particleVelocityY.empty() ? NULL : &particleVelocityY[0];
+    float *life = particleLife.empty() ? NULL : &particleLife[0];
+
+    #ifdef FLX_SSE
+    __m128 dt4 = _mm_set1_ps(dt);
+    __m128 dv4 = _mm_set1_ps(dv);
+    __m128 zero = _mm_setzero_ps();
+
+    for(; i < count; i += 4) {
+        __m128 velX = _mm_loadu_ps(vx + i);
+        __m128 velY = _mm_loadu_ps(vy + i);
+
+        _mm_storeu_ps(px + i, _mm_add_ps(_mm_loadu_ps(px + i), _mm_mul_ps(velX, dt4)));
+        _mm_storeu_ps(py + i, _mm_add_ps(_mm_loadu_ps(py + i), _mm_mul_ps(velY, dt4)));
+        _mm_storeu_ps(vy + i, _mm_add_ps(velY, dv4));
+
+        __m128 left = _mm_sub_ps(_mm_loadu_ps(life + i), dt4);
+        _mm_storeu_ps(life + i, left);
+
+        live += MaskBits[_mm_movemask_ps(_mm_cmpgt_ps(left, zero))];
+    }
+    #endif
+
+    for(; i < count; i++) {
+        px[i] += vx[i] * dt;
+        py[i] += vy[i] * dt;
+        vy[i] += dv;
+        life[i] -= dt;
+
+        if(life[i] > 0) live++;
+    }
+
+    liveParticles = live;
+    lastBatchUpdate = FlxG::updatesCount;
+}
+
+
+void FlxEmitter::drawBatched() {
+    if(!graphic || liveParticles == 0) return;
+
+    FLX_PROFILE_ZONE("FlxEmitter::drawBatched");
+
+    FlxVector move = FlxG::scroolVector;
+    move.x *= scroolFactor.x;
+    move.y *= scroolFactor.y;
+    if(!scrool) { move.x = move.y = 0; }
+
+    // step back to interpolated position (particles move linearly within one step)
+    float back = 0;
+    float dt = FlxG::fixedTime;
+
+    if(FlxG::interpolation && lastBatchUpdate == FlxG::updatesCount) {
+        back = (1.f - FlxG::interpolationAlpha) * dt;
+    }
+
+    float dv = gravity * dt;
+    unsigned int count = 0;
+
+    for(unsigned int i = 0; i < usedSlots; i++) {
+        if(particleLife[i] <= 0) continue;
+
+        FlxBatchSprite& sprite = batch[count++];
+        sprite.x = particleX[i] - particleVelocityX[i] * back + move.x;
+        sprite.y = particleY[i] - (particleVelocityY[i] - dv) * back + move.y;
+        sprite.angle = particleAngle[i];
+        sprite.source = frames[(particleFrame[i] < frames.size()) ? particleFrame[i] : 0];
+    }
+
+    FlxG::renderer.drawImages(graphic, &batch[0], count, FlxVector(1, 1), 0xffffff, 1.f);
 }
 
 
 void FlxEmitter::update() {
 
+    if(capacity > 0) updateBatched();
+
     for(unsigned int i = 0; i < members.size(); i++) {
         FlxParticle *part = (FlxParticle*)members[i];
-        if(part->timeToLife == -1.f) continue;
+        if(!part || part->timeToLife == -1.f) continue;
 
         if(part->timeToLife <= 0) {
             remove(part);
@@ -100,5 +288,6 @@ void FlxEmitter::update() {
 
 
 void FlxEmitter::draw() {
+    if(capacity > 0) drawBatched();
     FlxGroup::draw();
 }
@@ -12,19 +12,32 @@ FlxPreloader *FlxG::preloader = NULL;
 FlxMusic *FlxG::music = 0;
 FlxRect FlxG::worldBounds;
 FlxVector FlxG::scroolVector;
-FlxObject *FlxG::toFollow = NULL;
+FlxVector FlxG::lastScroolVector;
+FlxHandle FlxG::toFollow = FLX_NO_HANDLE;
 std::vector<FlxMouse*> FlxG::mousesList;
 FlxMouseHolder FlxG::mouse;
 float FlxG::fps = 0;
 float FlxG::fpsCounter = 0;
 float FlxG::totalTime = 0;
 float FlxG::fixedTime = 0.01f;
+FlxTimestep FlxG::timestep;
+FlxJobs FlxG::jobs;
+FlxRenderer FlxG::renderer;
+bool FlxG::interpolation = false;
+float FlxG::interpolationAlpha = 0;
+unsigned int FlxG::updatesCount = 0;
 FlxSprite FlxG::flashSprite;
 float FlxG::flashCounter = 0, FlxG::flashMaxTime = 0;
 bool FlxG::flashing = false;
 tween::Tweener FlxG::tweener;
 FlxShadersList FlxG::shaders;
 FlxState *FlxG::stateToSwitch = NULL;
+FlxState *FlxG::stateToLoad = NULL;
+FlxJobHandle FlxG::stateLoadJob;
+bool FlxG::stateLoadStarted = false;
+unsigned long long FlxG::switchRequestTime = 0;
+float FlxG::loadingBudget = 0.005f;
+float FlxG::lastSwitchTime = 0;
 FlxScriptEngine *FlxG::scriptEngine;
 FlxScriptsList FlxG::globalScripts;
 
@@ -62,6 +75,8 @@ int FlxG::setup(const char *title, int Width, int Height, FlxState *state,
 	screenHeight = static_cast<int>(screenSize.y);
 
     key = new FlxKeyboard();
+    if(!jobs.isInitialized()) jobs.init();
+
     srand(static_cast<unsigned int>(time(0)));
 
     scriptEngine = new FlxScriptEngine();
@@ -74,17 +89,7 @@ int FlxG::setup(const char *title, int Width, int Height, FlxState *state,
     flashSprite.alpha = 0;
 
     // run init event on scripts
-    #ifndef FLX_NO_SCRIPT
-    for(unsigned int i = 0; i < globalScripts.members.size(); i++) {
-        FlxScript *script = globalScripts.members[i];
-        FLX_CONTEXT *ctx;
-
-        if((ctx = script->findFunction("void onApplicationInit()")) != NULL) {
-            ctx->Execute();
-            script->endCall(ctx);
-        }
-    }
-    #endif
+    globalScripts.callEvent(FLX_SCRIPT_APPLICATION_INIT);
 
     // run preloader
     if(preloader) {
@@ -96,51 +101,185 @@ int FlxG::setup(const char *title, int Width, int Height, FlxState *state,
     }
 
     switchState(state);
+    FlxProfiler::setThreadName("Main");
 
     // main loop
     backend->mainLoop(innerUpdate, innerDraw);
 
+    // render thread mustn't use anything destroyed below
+    renderer.shutdown();
+
 
     // run exit event on scripts
-    #ifndef FLX_NO_SCRIPT
-    for(unsigned int i = 0; i < globalScripts.members.size(); i++) {
-        FlxScript *script = globalScripts.members[i];
-        FLX_CONTEXT *ctx;
-
-        if((ctx = script->findFunction("void onApplicationExit()")) != NULL) {
-            ctx->Execute();
-            script->endCall(ctx);
-        }
+    globalScripts.callEvent(FLX_SCRIPT_APPLICATION_EXIT);
+
+    // NOTE: initial state could be already switched and deleted
+    if(FlxG::state) {
+        FlxG::state->leave();
+        delete FlxG::state;
+        FlxG::state = NULL;
     }
-    #endif
 
-    if(state) {
-        state->leave();
-        delete state;
+    if(stateToSwitch) {
+        delete stateToSwitch;
+        stateToSwitch = NULL;
     }
 
+    cancelLoading();
+
+    tweener.removeTween(NULL);
+    toFollow = FLX_NO_HANDLE;
+
     scriptEngine->finalize();
     delete scriptEngine;
     delete key;
 
     shaders.clear();
     globalScripts.clear();
+    FlxSound::Voices.clear();
+    jobs.shutdown();
 
     backend->exitApplication();
     return 0;
 }
 
 void FlxG::followObject(FlxObject *object) {
-    toFollow = object;
+    toFollow = object ? object->handle : FLX_NO_HANDLE;
 }
 
 
 void FlxG::switchState(FlxState *newState) {
     if(!newState) return;
+
+    cancelLoading();
     stateToSwitch = newState;
 }
 
 
+void FlxG::switchStateAsync(FlxState *newState, FlxState *transition) {
+    if(!newState) return;
+
+    cancelLoading();
+    if(transition) stateToSwitch = transition;
+
+    stateToLoad = newState;
+    stateLoadStarted = false;
+    switchRequestTime = FlxProfiler::getTime();
+}
+
+
+bool FlxG::isLoadingState() {
+    return stateToLoad != NULL;
+}
+
+
+void FlxG::swapState(FlxState *newState) {
+    if(state) {
+        state->leave();
+
+        globalScripts.callEvent(FLX_SCRIPT_STAGE_END);
+
+        delete state;
+    }
+
+    shaders.clear();
+    tweener.removeTween(NULL);
+    worldBounds.x = worldBounds.y = scroolVector.x = scroolVector.y = 0.f;
+    worldBounds.width = width;
+    worldBounds.height = height;
+    toFollow = FLX_NO_HANDLE;
+
+    state = newState;
+    state->create();
+
+    globalScripts.callEvent(FLX_SCRIPT_STAGE_BEGIN);
+}
+
+
+bool FlxG::warmUpState(FlxState *loading) {
+    unsigned long long start = FlxProfiler::getTime();
+    unsigned int images = loading->imagesToPreload.size();
+    unsigned int fonts = loading->fontsToPreload.size();
+    unsigned int assets = images + fonts + loading->soundsToPreload.size();
+
+    // at least one asset per update, then as many as fits in budget
+    while(loading->assetsPreloaded < assets) {
+        unsigned int i = loading->assetsPreloaded;
+
+        if(i < images) {
+            if(!backend->loadImage(loading->imagesToPreload[i].c_str())) {
+                std::cerr << "[Error] Cannot preload " << loading->imagesToPreload[i] << std::endl;
+            }
+        }
+        else if(i < images + fonts) {
+            std::pair<std::string, int>& font = loading->fontsToPreload[i - images];
+
+            if(!backend->loadFont(font.first.c_str(), font.second)) {
+                std::cerr << "[Error] Cannot preload " << font.first << std::endl;
+            }
+        }
+        else {
+            const std::string& sound = loading->soundsToPreload[i - images - fonts];
+
+            if(!backend->loadSound(sound.c_str())) {
+                std::cerr << "[Error] Cannot preload " << sound << std::endl;
+            }
+        }
+
+        loading->assetsPreloaded++;
+        if(FlxProfiler::getTime() - start >= (unsigned long long)(loadingBudget * 1e9f)) break;
+    }
+
+    return loading->assetsPreloaded >= assets;
+}
+
+
+void FlxG::updateLoading() {
+    FLX_PROFILE_ZONE("Load state");
+
+    FlxState *loading = stateToLoad;
+
+    if(!stateLoadStarted) {
+        if(!warmUpState(loading)) return;
+
+        stateLoadStarted = true;
+
+        if(backend->isAsyncLoadingSupported() && jobs.getWorkersCount() > 0) {
+            stateLoadJob = jobs.add([loading]() {
+                FLX_PROFILE_ZONE("FlxState::load");
+                loading->load();
+            });
+        }
+        else {
+            // backend can't load from other threads, so do it now (transition state is already shown)
+            loading->load();
+        }
+    }
+
+    if(!jobs.isDone(stateLoadJob) || !loading->isReady()) return;
+
+    stateLoadJob.reset();
+    stateToLoad = NULL;
+
+    swapState(loading);
+
+    lastSwitchTime = (FlxProfiler::getTime() - switchRequestTime) / 1e9f;
+    std::cout << "[Info] State switched in " << (int)(lastSwitchTime * 1000.f) << " ms" << std::endl;
+}
+
+
+void FlxG::cancelLoading() {
+    if(!stateToLoad) return;
+
+    // load() can't be interrupted
+    jobs.wait(stateLoadJob);
+    stateLoadJob.reset();
+
+    delete stateToLoad;
+    stateToLoad = NULL;
+}
+
+
 FlxSound FlxG::play(const char *path, float vol) {
     FlxSound s(path);
     s.play(vol);
@@ -192,90 +331,50 @@ FlxBasic* FlxG::collide(FlxBasic *one, FlxBasic *two, const FlxBasic::CollisionC
 
 
 void FlxG::innerUpdate() {
+    FLX_PROFILE_ZONE("FlxG::innerUpdate");
+
+    updatesCount++;
 
     // switch state?
     if(stateToSwitch) {
-        if(state) {
-            state->leave();
-
-            #ifndef FLX_NO_SCRIPT
-            for(unsigned int i = 0; i < globalScripts.members.size(); i++) {
-                FlxScript *script = globalScripts.members[i];
-                FLX_CONTEXT *ctx;
-
-                if((ctx = script->findFunction("void onStageEnd()")) != NULL) {
-                    ctx->Execute();
-                    script->endCall(ctx);
-                }
-            }
-            #endif
-
-            delete state;
-        }
-
-        shaders.clear();
-        tweener.removeTween(NULL);
-        worldBounds.x = worldBounds.y = scroolVector.x = scroolVector.y = 0.f;
-		worldBounds.width = width;
-		worldBounds.height = height;
-        toFollow = NULL;
-
-        state = stateToSwitch;
-        state->create();
+        FLX_PROFILE_ZONE("Switch state");
 
+        FlxState *newState = stateToSwitch;
         stateToSwitch = NULL;
 
-        #ifndef FLX_NO_SCRIPT
-        for(unsigned int i = 0; i < globalScripts.members.size(); i++) {
-            FlxScript *script = globalScripts.members[i];
-            FLX_CONTEXT *ctx;
+        swapState(newState);
+    }
 
-            if((ctx = script->findFunction("void onStageBegin()")) != NULL) {
-                ctx->Execute();
-                script->endCall(ctx);
-            }
-        }
-        #endif
+    // or load one in background
+    if(stateToLoad) {
+        updateLoading();
     }
 
     // sounds and music garbage collector
-    for(unsigned int i = 0; i < FlxSound::Sounds.size(); i++) {
-        if(FlxSound::Sounds[i]) {
-            if(!FlxSound::Sounds[i]->isPlaying()) {
-                delete FlxSound::Sounds[i];
-                FlxSound::Sounds.erase(FlxSound::Sounds.begin() + i);
-            }
-        }
-        else {
-            FlxSound::Sounds.erase(FlxSound::Sounds.begin() + i);
-        }
-    }
+    {
+        FLX_PROFILE_ZONE("Sounds GC");
 
-    for(unsigned int i = 0; i < FlxMusic::Music.size(); i++) {
-        if(FlxMusic::Music[i]) {
-            if(!FlxMusic::Music[i]->isPlaying()) {
-                delete FlxMusic::Music[i];
-				FlxMusic::Music[i] = NULL;
+        FlxSound::Voices.update();
+
+        for(unsigned int i = 0; i < FlxMusic::Music.size(); i++) {
+            if(FlxMusic::Music[i]) {
+                if(!FlxMusic::Music[i]->isPlaying()) {
+                    delete FlxMusic::Music[i];
+                    FlxMusic::Music[i] = NULL;
+                    FlxMusic::Music.erase(FlxMusic::Music.begin() + i);
+                }
+            }
+            else {
                 FlxMusic::Music.erase(FlxMusic::Music.begin() + i);
             }
         }
-        else {
-            FlxMusic::Music.erase(FlxMusic::Music.begin() + i);
-        }
     }
 
     // call onFrameEnter on all utiltiy scripts
-    #ifndef FLX_NO_SCRIPT
-    for(unsigned int i = 0; i < globalScripts.members.size(); i++) {
-        FlxScript *script = globalScripts.members[i];
-        FLX_CONTEXT *ctx;
-
-        if((ctx = script->findFunction("void onFrameEnter()")) != NULL) {
-            ctx->Execute();
-            script->endCall(ctx);
-        }
+    {
+        FLX_PROFILE_ZONE("Scripts");
+        globalScripts.callEvent(FLX_SCRIPT_FRAME_ENTER);
     }
-    #endif
 
     // update fps
     fpsCounter += elapsed;
@@ -305,8 +404,14 @@ void FlxG::innerUpdate() {
     }
 
     // follow some object?
-    if(toFollow) {
-        FlxVector objectCenter = toFollow->getCenter();
+    lastScroolVector = scroolVector;
+
+    FlxObject *target = FlxHandles::getObject(toFollow);
+
+    if(target) {
+        FLX_PROFILE_ZONE("Camera");
+
+        FlxVector objectCenter = target->getCenter();
 
 		FlxVector move(objectCenter.x - (width / 2), objectCenter.y - (height / 2));
 
@@ -324,15 +429,24 @@ void FlxG::innerUpdate() {
     }
 
 
-    if(state) state->update();
+    if(state) {
+        FLX_PROFILE_ZONE("State::update");
+        state->update();
+    }
 
     // update tweener
-    tweener.step(int(totalTime * 1000));
+    {
+        FLX_PROFILE_ZONE("Tweener");
+        tweener.step(int(totalTime * 1000));
+    }
     totalTime += fixedTime;
 
     // update input devices
-    updateMouses();
-    key->updateState();
+    {
+        FLX_PROFILE_ZONE("Input");
+        updateMouses();
+        key->updateState();
+    }
 
     // handle flashing sprite
     if(flashing) flashSprite.update();
@@ -343,33 +457,47 @@ void FlxG::innerDraw() {
 
     if(exitMessage) return;
 
-    // call onRender on all utiltiy scripts
-    #ifndef FLX_NO_SCRIPT
-    for(unsigned int i = 0; i < globalScripts.members.size(); i++) {
-        FlxScript *script = globalScripts.members[i];
-        FLX_CONTEXT *ctx;
+    // move camera between two last positions too
+    FlxVector currentScrool = scroolVector;
+    if(interpolation) {
+        scroolVector.x = lastScroolVector.x + (currentScrool.x - lastScroolVector.x) * interpolationAlpha;
+        scroolVector.y = lastScroolVector.y + (currentScrool.y - lastScroolVector.y) * interpolationAlpha;
+    }
+
+    {
+        FLX_PROFILE_ZONE("FlxG::innerDraw");
 
-        if((ctx = script->findFunction("void onRender()")) != NULL) {
-            ctx->Execute();
-            script->endCall(ctx);
+        // call onRender on all utiltiy scripts
+        {
+            FLX_PROFILE_ZONE("Scripts");
+            globalScripts.callEvent(FLX_SCRIPT_RENDER);
+        }
+
+        if(state) {
+            FLX_PROFILE_ZONE("State::draw");
+            state->draw();
         }
-    }
-    #endif
 
-    if(state) state->draw();
+        // draw shaders
+        for(unsigned int i = 0; i < shaders.members.size(); i++) {
+            if(shaders.members[i] && shaders.members[i]->data) {
+                FLX_PROFILE_ZONE("Backend::drawShader");
+                renderer.drawShader(shaders.members[i]->data);
+            }
+        }
 
-    // draw shaders
-    for(unsigned int i = 0; i < shaders.members.size(); i++) {
-        if(shaders.members[i] && shaders.members[i]->data) {
-            backend->drawShader(shaders.members[i]->data);
+        // draw GUI
+        if(state) {
+            FLX_PROFILE_ZONE("State::drawGUI");
+            state->drawGUI();
         }
-    }
 
-    // draw GUI
-    if(state) state->drawGUI();
+        // handle flashing sprite
+        if(flashing) flashSprite.draw();
+    }
 
-    // handle flashing sprite
-    if(flashing) flashSprite.draw();
+    scroolVector = currentScrool;
+    FlxProfiler::frameMark();
 }
 
 
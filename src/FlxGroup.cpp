@@ -1,45 +1,186 @@
 #include "FlxGroup.h"
 #include "FlxObject.h"
+#include "FlxProfiler.h"
+#include "FlxG.h"
+#include <algorithm>
+
+// count of groups which are updated in parallel right now
+static std::atomic<int> ParallelUpdates(0);
+
+// is current thread updating members of parallel group? (other jobs, like background
+// state loading, change their groups immediately)
+static FLX_THREAD_LOCAL int UpdatingMembers = 0;
+
+
+// sleepers are merged into sorted list when there are enough new ones (or tombstones of woken ones)
+static const unsigned int MinNewSleepers = 64;
+
+// groups with changes deferred by parallel update
+static FlxMutex PendingMutex;
+static std::vector<FlxGroup*> PendingGroups;
+
 
 FlxGroup::FlxGroup() {
     entityType = FLX_GROUP;
+    parallelUpdate = false;
+    parallelGrain = 256;
+    flattenDraw = false;
+    sortMode = FLX_SORT_NONE;
+    compactionMode = FLX_COMPACT_STABLE;
+    holes = 0;
+    version = 0;
+    subgroupsCount = 0;
+    sleepDistance = 0;
+    sleepersHoles = 0;
+    asleepCount = 0;
+    awakeHoles = 0;
+    partitioned = false;
+    broadphaseThreshold = 32;
+    broadphaseCellSize = 0;
+    broadphaseMode = FLX_BROADPHASE_HASH;
+    builtMode = FLX_BROADPHASE_HASH;
+    builtPacked = false;
+    broadphaseVersion = 0;
+    broadphaseValid = false;
+    broadphaseStep = 0;
+    broadphaseQueries = 0;
+    sweepVersion = 0;
+    sweepAxis = -1;
+    sweeping = false;
 }
 
 
 FlxGroup::~FlxGroup() {
+    if(!pendingChanges.empty()) {
+        FlxLock lock(PendingMutex);
+
+        for(unsigned int i = 0; i < PendingGroups.size(); i++) {
+            if(PendingGroups[i] == this) {
+                PendingGroups.erase(PendingGroups.begin() + i);
+                break;
+            }
+        }
+    }
+
     clear();
 }
 
 
+void FlxGroup::defer(PendingChange::Type type, FlxBasic *object, bool dontDelete) {
+    PendingChange change;
+    change.type = type;
+    change.object = object;
+    change.dontDelete = dontDelete;
+
+    FlxLock lock(PendingMutex);
+
+    if(pendingChanges.empty()) PendingGroups.push_back(this);
+    pendingChanges.push_back(change);
+}
+
+
+void FlxGroup::applyPendingChanges() {
+    // one group at a time, because applied changes may delete other pending groups
+    for(;;) {
+        FlxGroup *group;
+        std::vector<PendingChange> changes;
+
+        {
+            FlxLock lock(PendingMutex);
+            if(PendingGroups.empty()) break;
+
+            group = PendingGroups.front();
+            PendingGroups.erase(PendingGroups.begin());
+            changes.swap(group->pendingChanges);
+        }
+
+        for(unsigned int i = 0; i < changes.size(); i++) {
+            PendingChange& change = changes[i];
+
+            if(change.type == PendingChange::ADD) group->add(change.object);
+            else if(change.type == PendingChange::REMOVE) group->remove(change.object, change.dontDelete);
+            else if(change.type == PendingChange::SLEEP) group->sleep(change.object);
+            else if(change.type == PendingChange::WAKE) group->wake(change.object);
+            else change.object->kill();
+        }
+    }
+}
+
+
 FlxBasic* FlxGroup::add(FlxBasic *object) {
 
+    if(object && UpdatingMembers > 0) {
+        defer(PendingChange::ADD, object);
+        return object;
+    }
+
     if(object) {
         object->scroolFactor = scroolFactor;
+        object->memberIndex = members.size();
+        object->sleeping = false;
         members.push_back(object);
+        version++;
+
+        if(partitioned) addAwake(object);
+
+        if(object->entityType == FLX_GROUP) subgroupsCount++;
     }
 
     return object;
 }
 
 
+int FlxGroup::indexOf(FlxBasic *object) {
+    unsigned int index = object->memberIndex;
+    if(index < members.size() && members[index] == object) return index;
+
+    // index is out of date (entity belongs to more groups or members were changed by hand)
+    for(unsigned int i = 0; i < members.size(); i++) {
+        if(members[i] == object) return i;
+    }
+
+    return -1;
+}
+
+
 bool FlxGroup::remove(FlxBasic *object, bool dontDelete) {
 
     if(!object) return false;
 
-    for(unsigned int i = 0; i < members.size(); i++) {
-        if(members[i] == object) {
+    int index = indexOf(object);
+    if(index < 0) return false;
 
-            if(!dontDelete) {
-                delete members[i];
-                members[i] = NULL;
-            }
-
-            members.erase(members.begin() + i);
-            return true;
-        }
+    if(UpdatingMembers > 0) {
+        defer(PendingChange::REMOVE, object, dontDelete);
+        return true;
     }
 
-    return false;
+    if(object->poolKey) removeFromPool(object);
+
+    if(object->sleeping) removeSleeper(object);
+    else if(partitioned) removeAwake(object);
+
+    // leave a hole, so loops over members don't skip anything
+    members[index] = NULL;
+    holes++;
+    version++;
+
+    if(object->entityType == FLX_GROUP) subgroupsCount--;
+
+    if(!dontDelete) removedMembers.push_back(object);
+    return true;
+}
+
+
+void FlxGroup::killMember(FlxBasic *object) {
+    if(!object) return;
+
+    if(UpdatingMembers > 0) {
+        defer(PendingChange::KILL, object);
+    }
+    else {
+        object->kill();
+    }
 }
 
 
@@ -48,58 +189,928 @@ void FlxGroup::clear() {
         delete *it;
     }
 
+    for(auto it = removedMembers.begin(); it != removedMembers.end(); it++) {
+        delete *it;
+    }
+
     members.clear();
+    removedMembers.clear();
+    pools.clear();
+    sleepers.clear();
+    newSleepers.clear();
+    awake.clear();
+
+    holes = 0;
+    sleepersHoles = 0;
+    asleepCount = 0;
+    awakeHoles = 0;
+    partitioned = false;
+    subgroupsCount = 0;
+    version++;
+}
+
+
+void FlxGroup::compact() {
+    if(holes > 0) {
+        unsigned int count = 0;
+
+        if(compactionMode == FLX_COMPACT_SWAP) {
+            unsigned int end = members.size();
+
+            // fill every hole with the last member
+            while(count < end) {
+                if(members[count]) {
+                    count++;
+                    continue;
+                }
+
+                end--;
+
+                if(members[end]) {
+                    members[count] = members[end];
+                    members[count]->memberIndex = count;
+                    count++;
+                }
+            }
+
+            version++;
+        }
+        else {
+            for(unsigned int i = 0; i < members.size(); i++) {
+                if(members[i]) {
+                    members[count] = members[i];
+                    members[count]->memberIndex = count;
+                    count++;
+                }
+            }
+        }
+
+        members.resize(count);
+        holes = 0;
+    }
+
+    if(partitioned) {
+        if(asleepCount == 0) {
+            // everybody is awake again, members are updated directly
+            awake.clear();
+            awakeHoles = 0;
+            partitioned = false;
+        }
+        else if(awakeHoles > 0) {
+            unsigned int count = 0;
+
+            for(unsigned int i = 0; i < awake.size(); i++) {
+                if(awake[i]) {
+                    awake[count] = awake[i];
+                    awake[count]->awakeIndex = count;
+                    count++;
+                }
+            }
+
+            awake.resize(count);
+            awakeHoles = 0;
+        }
+    }
+
+    mergeSleepers();
+
+    // destructors may remove other members, so the size is checked every time
+    for(unsigned int i = 0; i < removedMembers.size(); i++) {
+        delete removedMembers[i];
+    }
+
+    removedMembers.clear();
+}
+
+
+unsigned int FlxGroup::getVersion() {
+    return version;
+}
+
+
+FlxBasic* FlxGroup::reuse(const void *key) {
+    std::map<const void*, Pool>::iterator it = pools.find(key);
+    if(it == pools.end()) return NULL;
+
+    Pool& pool = it->second;
+    unsigned int count = pool.objects.size();
+
+    // the first dead member after the last reused one
+    for(unsigned int i = 0; i < count; i++) {
+        unsigned int index = (pool.next + i) % count;
+        FlxBasic *object = pool.objects[index];
+
+        if(!object->alive) {
+            pool.next = (index + 1) % count;
+            object->revive();
+            if(object->sleeping) wake(object);
+            return object;
+        }
+    }
+
+    // pool is full, take the oldest one
+    if(pool.maxSize > 0 && count >= pool.maxSize) {
+        FlxBasic *object = pool.objects[pool.next];
+        pool.next = (pool.next + 1) % count;
+
+        object->kill();
+        object->revive();
+        if(object->sleeping) wake(object);
+        return object;
+    }
+
+    return NULL;
+}
+
+
+void FlxGroup::addToPool(const void *key, FlxBasic *object) {
+    object->poolKey = key;
+    pools[key].objects.push_back(object);
+    add(object);
+}
+
+
+void FlxGroup::removeFromPool(FlxBasic *object) {
+    std::map<const void*, Pool>::iterator it = pools.find(object->poolKey);
+    object->poolKey = NULL;
+
+    if(it == pools.end()) return;
+
+    std::vector<FlxBasic*>& objects = it->second.objects;
+
+    for(unsigned int i = 0; i < objects.size(); i++) {
+        if(objects[i] == object) {
+            objects.erase(objects.begin() + i);
+            break;
+        }
+    }
+
+    if(it->second.next >= objects.size()) it->second.next = 0;
 }
 
 
 unsigned int FlxGroup::size() {
-    return members.size();
+    return members.size() - holes;
 }
 
 
 void FlxGroup::update() {
+    FLX_PROFILE_ZONE("FlxGroup::update");
 
-    for(unsigned int i = 0; i < members.size(); i++) {
-        if(members[i]) members[i]->update();
+    compact();
+
+    if(sleepDistance > 0) wakeInRect(getWakeArea());
+
+    // sleeping members aren't even touched
+    std::vector<FlxBasic*>& list = partitioned ? awake : members;
+
+    if(!parallelUpdate || list.size() <= parallelGrain || FlxG::jobs.getWorkersCount() == 0) {
+        // members added meanwhile are updated too
+        updateMembers(list, 0, std::numeric_limits<unsigned int>::max());
     }
+    else {
+        ParallelUpdates++;
+
+        FlxG::jobs.parallelFor(0, list.size(), [this, &list](unsigned int begin, unsigned int end) {
+            FLX_PROFILE_ZONE("FlxGroup::update chunk");
+            UpdatingMembers++;
+            updateMembers(list, begin, end);
+            UpdatingMembers--;
+        }, parallelGrain);
+
+        // merge structural changes when the outermost parallel update is done
+        if(--ParallelUpdates == 0) applyPendingChanges();
+    }
+
+    if(sleepDistance > 0) sleepDistantMembers();
+
+    if(sortMode != FLX_SORT_NONE) sort();
 }
 
 
-void FlxGroup::drawGUI() {
+void FlxGroup::updateMembers(std::vector<FlxBasic*>& list, unsigned int begin, unsigned int end) {
+    for(unsigned int i = begin; i < end && i < list.size(); i++) {
+        FlxBasic *member = list[i];
+        if(member && member->active) member->update();
+    }
+}
+
+
+/*
+*  Point used to find sleeping member (subgroups have none, they are woken only by wake())
+*/
+static inline void getSleepPosition(FlxBasic *member, float& x, float& y) {
+    if(member->entityType == FLX_OBJECT) {
+        FlxObject *obj = (FlxObject*) member;
+        x = obj->x + obj->width * 0.5f;
+        y = obj->y + obj->height * 0.5f;
+    }
+    else {
+        x = y = -std::numeric_limits<float>::max();
+    }
+}
+
+
+/*
+*  Sleepers ordered by x
+*/
+struct SleeperBefore {
+    template<class T> bool operator()(const T& a, const T& b) const {
+        return a.x < b.x;
+    }
+
+    template<class T> bool operator()(const T& a, float x) const {
+        return a.x < x;
+    }
+};
+
+
+int FlxGroup::awakeIndexOf(FlxBasic *member) {
+    unsigned int index = member->awakeIndex;
+    if(index < awake.size() && awake[index] == member) return index;
+
+    for(unsigned int i = 0; i < awake.size(); i++) {
+        if(awake[i] == member) return i;
+    }
+
+    return -1;
+}
+
+
+void FlxGroup::addAwake(FlxBasic *member) {
+    member->awakeIndex = awake.size();
+    awake.push_back(member);
+}
+
+
+void FlxGroup::removeAwake(FlxBasic *member) {
+    int index = awakeIndexOf(member);
+    if(index < 0) return;
+
+    // hole, like in members, so update loop doesn't skip anything
+    awake[index] = NULL;
+    awakeHoles++;
+}
+
+
+void FlxGroup::removeSleeper(FlxBasic *member) {
+    member->sleeping = false;
+    asleepCount--;
+
+    for(unsigned int i = 0; i < newSleepers.size(); i++) {
+        if(newSleepers[i].member == member) {
+            newSleepers[i] = newSleepers.back();
+            newSleepers.pop_back();
+            return;
+        }
+    }
+
+    float x, y;
+    getSleepPosition(member, x, y);
+
+    // woken members leave tombstones, they are dropped by the next merge
+    std::vector<Sleeper>::iterator it = std::lower_bound(sleepers.begin(), sleepers.end(), x, SleeperBefore());
+
+    for(; it != sleepers.end() && it->x == x; it++) {
+        if(it->member == member) {
+            it->member = NULL;
+            sleepersHoles++;
+            return;
+        }
+    }
+
+    // member was moved while sleeping
+    for(unsigned int i = 0; i < sleepers.size(); i++) {
+        if(sleepers[i].member == member) {
+            sleepers[i].member = NULL;
+            sleepersHoles++;
+            return;
+        }
+    }
+}
+
+
+void FlxGroup::mergeSleepers() {
+    unsigned int count = sleepers.size();
+    if(newSleepers.size() < MinNewSleepers + count / 16 && sleepersHoles <= count / 4) return;
+
+    std::sort(newSleepers.begin(), newSleepers.end(), SleeperBefore());
+
+    sleepersScratch.clear();
+    sleepersScratch.reserve(count - sleepersHoles + newSleepers.size());
+
+    unsigned int i = 0, j = 0;
+
+    while(i < count || j < newSleepers.size()) {
+        if(i < count && !sleepers[i].member) {
+            i++;
+        }
+        else if(j >= newSleepers.size() || (i < count && sleepers[i].x <= newSleepers[j].x)) {
+            sleepersScratch.push_back(sleepers[i++]);
+        }
+        else {
+            sleepersScratch.push_back(newSleepers[j++]);
+        }
+    }
+
+    sleepers.swap(sleepersScratch);
+    newSleepers.clear();
+    sleepersHoles = 0;
+}
+
+
+void FlxGroup::sleep(FlxBasic *member) {
+    if(!member) return;
+
+    if(UpdatingMembers > 0) {
+        defer(PendingChange::SLEEP, member);
+        return;
+    }
+
+    if(member->sleeping || indexOf(member) < 0) return;
+
+    if(!partitioned) {
+        awake.clear();
+
+        for(unsigned int i = 0; i < members.size(); i++) {
+            if(members[i]) addAwake(members[i]);
+        }
+
+        awakeHoles = 0;
+        partitioned = true;
+    }
+
+    removeAwake(member);
+
+    Sleeper sleeper;
+    getSleepPosition(member, sleeper.x, sleeper.y);
+    sleeper.member = member;
+
+    newSleepers.push_back(sleeper);
+    member->sleeping = true;
+    asleepCount++;
+}
+
+
+void FlxGroup::wake(FlxBasic *member) {
+    if(!member) return;
+
+    if(UpdatingMembers > 0) {
+        defer(PendingChange::WAKE, member);
+        return;
+    }
+
+    if(!member->sleeping || indexOf(member) < 0) return;
+
+    removeSleeper(member);
+    addAwake(member);
+}
+
+
+unsigned int FlxGroup::wakeInRect(const FlxRect& area) {
+    if(asleepCount == 0) return 0;
+
+    // other members may be looking at sleepers too, changes wait until update is done
+    bool deferred = UpdatingMembers > 0;
+    unsigned int woken = 0;
+
+    float right = area.x + area.width;
+    float bottom = area.y + area.height;
+
+    std::vector<Sleeper>::iterator it = std::lower_bound(sleepers.begin(), sleepers.end(), area.x, SleeperBefore());
+
+    for(; it != sleepers.end() && it->x <= right; it++) {
+        FlxBasic *member = it->member;
+        if(!member || it->y < area.y || it->y > bottom || member->entityType != FLX_OBJECT) continue;
+
+        if(deferred) {
+            defer(PendingChange::WAKE, member);
+        }
+        else {
+            it->member = NULL;
+            sleepersHoles++;
+            member->sleeping = false;
+            asleepCount--;
+            addAwake(member);
+        }
+
+        woken++;
+    }
+
+    // not merged ones (backwards, woken ones are swapped with the last one)
+    for(int i = newSleepers.size() - 1; i >= 0; i--) {
+        Sleeper& sleeper = newSleepers[i];
+
+        if(sleeper.x < area.x || sleeper.x > right || sleeper.y < area.y || sleeper.y > bottom) continue;
+        if(sleeper.member->entityType != FLX_OBJECT) continue;
+
+        if(deferred) {
+            defer(PendingChange::WAKE, sleeper.member);
+        }
+        else {
+            FlxBasic *member = sleeper.member;
+            sleeper = newSleepers.back();
+            newSleepers.pop_back();
+
+            member->sleeping = false;
+            asleepCount--;
+            addAwake(member);
+        }
+
+        woken++;
+    }
+
+    return woken;
+}
+
+
+FlxRect FlxGroup::getWakeArea() {
+    // camera's view in coordinates of members (the same scrool as in FlxSprite::draw())
+    float viewX = -FlxG::scroolVector.x * scroolFactor.x;
+    float viewY = -FlxG::scroolVector.y * scroolFactor.y;
+
+    return FlxRect(viewX - sleepDistance, viewY - sleepDistance,
+                   (int)(FlxG::width + sleepDistance * 2), (int)(FlxG::height + sleepDistance * 2));
+}
+
+
+void FlxGroup::sleepDistantMembers() {
+    FlxRect area = getWakeArea();
+    float right = area.x + area.width;
+    float bottom = area.y + area.height;
+
+    // sleep() only punches holes, so the list can be walked meanwhile
+    std::vector<FlxBasic*>& list = partitioned ? awake : members;
+
+    for(unsigned int i = 0; i < list.size(); i++) {
+        FlxBasic *member = list[i];
+        if(!member || member->entityType != FLX_OBJECT) continue;
+
+        float x, y;
+        getSleepPosition(member, x, y);
+
+        if(x < area.x || x > right || y < area.y || y > bottom) sleep(member);
+    }
+}
+
+
+unsigned int FlxGroup::getAwakeCount() {
+    return size() - asleepCount;
+}
+
+
+unsigned int FlxGroup::getAsleepCount() {
+    return asleepCount;
+}
+
+
+float FlxGroup::getSortKey(FlxBasic *member) {
+    if(sortMode == FLX_SORT_CUSTOM) return sortKey ? sortKey(member) : 0.f;
+    if(member->entityType != FLX_OBJECT) return 0.f;
+
+    FlxObject *obj = (FlxObject*) member;
+    return (sortMode == FLX_SORT_Z) ? obj->z : obj->y + obj->height;
+}
+
+
+/*
+*  Is a drawn before b? (texture breaks ties)
+*/
+static inline bool sortsBefore(float keyA, size_t texA, float keyB, size_t texB) {
+    return keyA < keyB || (keyA == keyB && texA < texB);
+}
+
+
+bool FlxGroup::insertionSort(unsigned int maxMoves) {
+    unsigned int moves = 0;
+
+    for(unsigned int i = 1; i < sortEntries.size(); i++) {
+        SortEntry entry = sortEntries[i];
+        unsigned int j = i;
+
+        while(j > 0 && sortsBefore(entry.key, entry.texture, sortEntries[j - 1].key, sortEntries[j - 1].texture)) {
+            sortEntries[j] = sortEntries[j - 1];
+            j--;
+
+            if(++moves > maxMoves) {
+                sortEntries[j] = entry;
+                return false;
+            }
+        }
+
+        sortEntries[j] = entry;
+    }
+
+    return true;
+}
+
+
+/*
+*  Texture order of entries with equal keys (stable)
+*/
+struct SortByTexture {
+    template<class T> bool operator()(const T& a, const T& b) const {
+        return a.texture < b.texture || (a.texture == b.texture && a.order < b.order);
+    }
+};
+
+
+/*
+*  Float as unsigned integer with the same order
+*/
+static inline unsigned int radixKey(float key) {
+    unsigned int bits;
+    memcpy(&bits, &key, sizeof(bits));
+
+    return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+}
+
+
+void FlxGroup::radixSort() {
+    static const unsigned int DigitBits = 11;
+    static const unsigned int Digits = 1 << DigitBits;
+    static const unsigned int Passes = 3;
+
+    // (key, position) pairs are sorted, entries are moved only once at the end
+    unsigned int count = sortEntries.size();
+    unsigned int histogram[Passes][Digits];
+    memset(histogram, 0, sizeof(histogram));
+
+    radixKeys.resize(count);
+    radixScratch.resize(count);
+
+    for(unsigned int i = 0; i < count; i++) {
+        unsigned int key = radixKey(sortEntries[i].key);
+        radixKeys[i] = ((unsigned long long)key << 32) | i;
+
+        for(unsigned int p = 0; p < Passes; p++) {
+            histogram[p][(key >> (p * DigitBits)) & (Digits - 1)]++;
+        }
+    }
+
+    // least significant digit first, every pass is stable
+    for(unsigned int p = 0; p < Passes; p++) {
+        unsigned int offset = 0;
+        unsigned int shift = 32 + p * DigitBits;
+
+        for(unsigned int d = 0; d < Digits; d++) {
+            unsigned int size = histogram[p][d];
+            histogram[p][d] = offset;
+            offset += size;
+        }
+
+        for(unsigned int i = 0; i < count; i++) {
+            unsigned int digit = (unsigned int)(radixKeys[i] >> shift) & (Digits - 1);
+            radixScratch[histogram[p][digit]++] = radixKeys[i];
+        }
+
+        radixKeys.swap(radixScratch);
+    }
+
+    sortScratch.resize(count);
+
+    for(unsigned int i = 0; i < count; i++) {
+        sortScratch[i] = sortEntries[(unsigned int) radixKeys[i]];
+    }
+
+    sortEntries.swap(sortScratch);
+
+    // keys only are sorted, now textures in every run of equal keys
+    for(unsigned int i = 0; i < count;) {
+        unsigned int end = i + 1;
+        while(end < count && sortEntries[end].key == sortEntries[i].key) end++;
+
+        if(end - i > 1) {
+            for(unsigned int j = i; j < end; j++) sortEntries[j].order = j;
+            std::sort(sortEntries.begin() + i, sortEntries.begin() + end, SortByTexture());
+        }
+
+        i = end;
+    }
+}
+
+
+void FlxGroup::sort() {
+    FLX_PROFILE_ZONE("FlxGroup::sort");
+
+    sortEntries.clear();
+
+    for(unsigned int i = 0; i < members.size(); i++) {
+        FlxBasic *member = members[i];
+        if(!member) continue;
+
+        SortEntry entry;
+        entry.key = getSortKey(member);
+        entry.texture = (member->entityType == FLX_OBJECT) ? (size_t)((FlxObject*) member)->getTextureKey() : 0;
+        entry.member = member;
+
+        sortEntries.push_back(entry);
+    }
+
+    // order of last frame is nearly sorted, moved members shift only a few places
+    if(!insertionSort(sortEntries.size() * 2)) radixSort();
+
+    // write back, holes stay in their places
+    bool changed = false;
+    unsigned int next = 0;
+
     for(unsigned int i = 0; i < members.size(); i++) {
-        if(members[i]) {
-            if(members[i]->entityType == FLX_OBJECT) {
-                FlxObject *obj = (FlxObject*) members[i];
-                if(obj->isGUI) obj->draw();
+        if(!members[i]) continue;
+
+        FlxBasic *member = sortEntries[next++].member;
+
+        if(members[i] != member) {
+            members[i] = member;
+            member->memberIndex = i;
+            changed = true;
+        }
+    }
+
+    if(changed) version++;
+}
+
+
+bool FlxGroup::isDrawCacheValid() {
+    if(!drawCache.valid || drawCache.version != version) return false;
+
+    // parents come before their subgroups, so removed (and deleted) subgroups are never touched
+    for(unsigned int i = 0; i < drawCache.groups.size(); i++) {
+        if(drawCache.groups[i].first->version != drawCache.groups[i].second) return false;
+    }
+
+    return true;
+}
+
+
+void FlxGroup::rebuildDrawCache() {
+    FLX_PROFILE_ZONE("FlxGroup::rebuildDrawCache");
+
+    drawCache.world.clear();
+    drawCache.gui.clear();
+    drawCache.groups.clear();
+
+    flattenMembers(this);
+
+    drawCache.version = version;
+    drawCache.valid = true;
+}
+
+
+void FlxGroup::flattenMembers(FlxGroup *group) {
+    for(unsigned int i = 0; i < group->members.size(); i++) {
+        FlxBasic *member = group->members[i];
+        if(!member) continue;
+
+        if(member->entityType == FLX_OBJECT) {
+            if(((FlxObject*) member)->isGUI) drawCache.gui.push_back(member);
+            else drawCache.world.push_back(member);
+        }
+        else {
+            FlxGroup *subgroup = (FlxGroup*) member;
+
+            if(subgroup->flattenDraw) {
+                drawCache.groups.push_back(std::make_pair(subgroup, subgroup->version));
+                flattenMembers(subgroup);
             }
             else {
-                FlxGroup *group = (FlxGroup*) members[i];
-                group->drawGUI();
+                // custom drawing, called as a whole in both passes
+                drawCache.world.push_back(member);
+                drawCache.gui.push_back(member);
+            }
+        }
+    }
+}
+
+
+void FlxGroup::drawGUI() {
+    if(subgroupsCount == 0) {
+        for(unsigned int i = 0; i < members.size(); i++) {
+            FlxBasic *member = members[i];
+            if(member && member->entityType == FLX_OBJECT && ((FlxObject*) member)->isGUI) member->draw();
+        }
+
+        return;
+    }
+
+    if(!isDrawCacheValid()) rebuildDrawCache();
+
+    bool changed = false;
+
+    for(unsigned int i = 0; i < drawCache.gui.size(); i++) {
+        FlxBasic *member = drawCache.gui[i];
+
+        if(member->entityType == FLX_OBJECT) {
+            FlxObject *obj = (FlxObject*) member;
+
+            if(!obj->isGUI) {
+                changed = true;
+                continue;
             }
+
+            obj->draw();
+        }
+        else {
+            ((FlxGroup*) member)->drawGUI();
         }
     }
+
+    if(changed) drawCache.valid = false;
 }
 
 
 void FlxGroup::draw() {
+    FLX_PROFILE_ZONE("FlxGroup::draw");
 
-    for(unsigned int i = 0; i < members.size(); i++) {
-        if(members[i]) {
-            if(members[i]->entityType == FLX_OBJECT) {
-                FlxObject *obj = (FlxObject*) members[i];
-                if(!obj->isGUI) obj->draw();
+    if(subgroupsCount == 0) {
+        for(unsigned int i = 0; i < members.size(); i++) {
+            FlxBasic *member = members[i];
+            if(member && member->entityType == FLX_OBJECT && !((FlxObject*) member)->isGUI) member->draw();
+        }
+
+        return;
+    }
+
+    bool valid = isDrawCacheValid();
+
+    // objects moved out of GUI since last frame (GUI list is short)
+    for(unsigned int i = 0; valid && i < drawCache.gui.size(); i++) {
+        FlxBasic *member = drawCache.gui[i];
+        if(member->entityType == FLX_OBJECT && !((FlxObject*) member)->isGUI) valid = false;
+    }
+
+    if(!valid) rebuildDrawCache();
+
+    bool changed = false;
+
+    for(unsigned int i = 0; i < drawCache.world.size(); i++) {
+        FlxBasic *member = drawCache.world[i];
+
+        if(member->entityType == FLX_OBJECT) {
+            FlxObject *obj = (FlxObject*) member;
+
+            // moved to GUI, GUI pass rebuilds lists and draws it
+            if(obj->isGUI) {
+                changed = true;
+                continue;
             }
-            else {
-                FlxGroup *group = (FlxGroup*) members[i];
-                group->draw();
+
+            obj->draw();
+        }
+        else {
+            ((FlxGroup*) member)->draw();
+        }
+    }
+
+    if(changed) drawCache.valid = false;
+}
+
+
+// smaller groups are checked by plain loops
+static const unsigned int MinPackedMembers = 8;
+
+
+bool FlxGroup::prepareBroadphase() {
+    // table is shared, so parallel updates don't touch it
+    if(broadphaseThreshold == 0 || size() < MinPackedMembers || UpdatingMembers > 0) return false;
+
+    // boxes are refreshed by the first query of step (table is rebuilt if members or mode changed)
+    bool packed = size() < broadphaseThreshold;
+
+    bool valid = broadphaseValid && broadphaseVersion == version && broadphaseStep == FlxG::updatesCount &&
+                 builtPacked == packed && (packed || builtMode == broadphaseMode);
+    if(!valid && broadphaseQueries == 0) rebuildBroadphase();
+
+    return true;
+}
+
+
+/*
+*  Hitbox and everything it passes through in one step (see FlxObject::collide())
+*/
+static inline void getSweptBox(FlxObject *obj, float dt, FlxBox& box) {
+    float moveX = obj->velocity.x * dt;
+    float moveY = obj->velocity.y * dt;
+
+    box.minX = obj->hitbox.x + std::min(moveX, 0.f);
+    box.minY = obj->hitbox.y + std::min(moveY, 0.f);
+    box.maxX = obj->hitbox.x + obj->hitbox.width + std::max(moveX, 0.f);
+    box.maxY = obj->hitbox.y + obj->hitbox.height + std::max(moveY, 0.f);
+}
+
+
+void FlxGroup::rebuildBroadphase() {
+    FLX_PROFILE_ZONE("FlxGroup::rebuildBroadphase");
+
+    float dt = FlxG::fixedTime;
+    float sizes = 0;
+    bool packed = size() < broadphaseThreshold;
+
+    broadphaseStep = FlxG::updatesCount;
+
+    if(broadphaseValid && broadphaseVersion == version && builtPacked == packed && (packed || builtMode == broadphaseMode)) {
+        // the same members, hash is kept if none of them moved (static groups, sleeping members)
+        bool moved = false;
+
+        for(unsigned int i = 0; i < broadphaseMembers.size(); i++) {
+            FlxBox box;
+            getSweptBox((FlxObject*) broadphaseMembers[i], dt, box);
+
+            FlxBox& old = broadphaseBoxes[i];
+
+            if(box.minX != old.minX || box.minY != old.minY || box.maxX != old.maxX || box.maxY != old.maxY) {
+                if(builtPacked) packedBoxes.set(i, box);
+                else if(builtMode == FLX_BROADPHASE_QUADTREE) quadTree.move(i, box);
+                moved = true;
+            }
+
+            old = box;
+            sizes += std::max(box.maxX - box.minX, box.maxY - box.minY);
+        }
+
+        if(!moved || builtPacked || builtMode == FLX_BROADPHASE_QUADTREE) return;
+    }
+    else {
+        broadphaseBoxes.clear();
+        broadphaseMembers.clear();
+        broadphaseIndices.clear();
+        broadphaseGroups.clear();
+
+        for(unsigned int i = 0; i < members.size(); i++) {
+            FlxBasic *member = members[i];
+            if(!member) continue;
+
+            if(member->entityType != FLX_OBJECT) {
+                broadphaseGroups.push_back(i);
+                continue;
             }
+
+            FlxBox box;
+            getSweptBox((FlxObject*) member, dt, box);
+            sizes += std::max(box.maxX - box.minX, box.maxY - box.minY);
+
+            broadphaseBoxes.push_back(box);
+            broadphaseMembers.push_back(member);
+            broadphaseIndices.push_back(i);
+        }
+    }
+
+    float averageSize = broadphaseBoxes.empty() ? 1.f : sizes / broadphaseBoxes.size();
+
+    if(packed) {
+        // ids are given in order of adding, the same as in broadphaseBoxes
+        packedBoxes.clear();
+
+        for(unsigned int i = 0; i < broadphaseBoxes.size(); i++) {
+            packedBoxes.add(broadphaseBoxes[i]);
+        }
+    }
+    else if(broadphaseMode == FLX_BROADPHASE_QUADTREE) {
+        FlxBox area = { 0.f, 0.f, 1.f, 1.f };
+        if(!broadphaseBoxes.empty()) area = broadphaseBoxes[0];
+
+        for(unsigned int i = 1; i < broadphaseBoxes.size(); i++) {
+            area.minX = std::min(area.minX, broadphaseBoxes[i].minX);
+            area.minY = std::min(area.minY, broadphaseBoxes[i].minY);
+            area.maxX = std::max(area.maxX, broadphaseBoxes[i].maxX);
+            area.maxY = std::max(area.maxY, broadphaseBoxes[i].maxY);
+        }
+
+        // the smallest nodes fit average member
+        float size = std::max(area.maxX - area.minX, area.maxY - area.minY);
+        unsigned int depth = 1;
+
+        while(depth < FlxQuadTree::MaxDepth && size / (1 << (depth + 1)) >= averageSize) depth++;
+
+        // ids are given in order of inserting, the same as in broadphaseBoxes
+        quadTree.setBounds(area, depth);
+
+        for(unsigned int i = 0; i < broadphaseBoxes.size(); i++) {
+            quadTree.insert(broadphaseBoxes[i]);
+        }
+    }
+    else {
+        float cellSize = (broadphaseCellSize > 0) ? broadphaseCellSize : std::max(averageSize * 2.f, 1.f);
+
+        spatialHash.begin(cellSize);
+
+        for(unsigned int i = 0; i < broadphaseBoxes.size(); i++) {
+            spatialHash.insert(broadphaseBoxes[i]);
         }
+
+        spatialHash.end();
     }
+
+    builtMode = broadphaseMode;
+    builtPacked = packed;
+    broadphaseVersion = version;
+    broadphaseValid = true;
 }
 
 
 FlxBasic* FlxGroup::overlaps(FlxBasic *object, const CollisionCallback& callback) {
 
+    if(!object) return NULL;
+
     if(object->entityType == FLX_OBJECT) {
         return object->overlaps(this, callback);
     }
@@ -117,12 +1128,27 @@ FlxBasic* FlxGroup::overlaps(FlxBasic *object, const CollisionCallback& callback
 
 FlxBasic* FlxGroup::collide(FlxBasic *object, const CollisionCallback& callback) {
 
+    if(!object) return NULL;
+
     if(object->entityType == FLX_OBJECT) {
         FlxBasic *ent = NULL;
+        FlxRect& hitbox = ((FlxObject*) object)->hitbox;
+
+        // members move towards object, their swept hitboxes are in the table already
+        FlxBox area = { hitbox.x, hitbox.y, hitbox.x + hitbox.width, hitbox.y + hitbox.height };
+
+        bool found = queryBroadphase(area, [&](FlxBasic *member) {
+            FlxBasic *hit = member->collide(object, callback);
+            if(hit) ent = hit;
+        });
+
+        if(found) return ent;
 
         for(int i = members.size() - 1; i >= 0; i--) {
-            FlxObject *obj = (FlxObject*)members[i];
-            ent = obj->collide(object, callback);
+            if(!members[i]) continue;
+
+            FlxBasic *hit = members[i]->collide(object, callback);
+            if(hit) ent = hit;
         }
 
         return ent;
@@ -131,10 +1157,24 @@ FlxBasic* FlxGroup::collide(FlxBasic *object, const CollisionCallback& callback)
         FlxGroup *group = (FlxGroup*)object;
         FlxBasic *ent = NULL;
 
-        for(int i = members.size() - 1; i >= 0; i--) {
+        // bigger group is in spatial hash, every object of the smaller one looks for members around it
+        if(size() >= group->size() && prepareBroadphase()) {
             for(int j = group->members.size() - 1; j >= 0; j--) {
-                ent = members[i]->collide(group->members[j], callback);
+                if(!group->members[j]) continue;
+
+                FlxBasic *hit = collide(group->members[j], callback);
+                if(hit) ent = hit;
             }
+
+            return ent;
+        }
+
+        // every member against the other group (which uses its own broadphase if it's big)
+        for(int i = members.size() - 1; i >= 0; i--) {
+            if(!members[i]) continue;
+
+            FlxBasic *hit = members[i]->collide(group, callback);
+            if(hit) ent = hit;
         }
 
         return ent;
@@ -144,37 +1184,195 @@ FlxBasic* FlxGroup::collide(FlxBasic *object, const CollisionCallback& callback)
 }
 
 
-FlxGroup::EntitiesSet FlxGroup::selfOverlaps(const CollisionCallback& callback) {
-    FlxGroup::EntitiesSet set = { 0, 0 };
+// axis is changed only when the other one is clearly better (every change sorts from scratch)
+static const float SweepAxisSwitchRatio = 1.5f;
 
-    for(unsigned int i = 0; i < members.size(); i++) {
-        for(int j = members.size() - 1; j >= 0; j--) {
-            if((members[i] != members[j]) && members[i]->overlaps(members[j])) {
-                set.first = members[i];
-                set.second = members[j];
 
-                if(callback != nullptr) callback(set.first, set.second);
+template<class F> void FlxGroup::sweepPairs(bool swept, F visit) {
+
+    // called from collision callback, entries are in use
+    if(sweeping) {
+        for(unsigned int i = 0; i < members.size(); i++) {
+            for(unsigned int j = i + 1; j < members.size(); j++) {
+                if(members[i] && members[j] && members[i]->alive && members[j]->alive) visit(members[i], members[j]);
+            }
+        }
+
+        return;
+    }
+
+    bool resort = false;
+
+    if(sweepAxis < 0 || sweepVersion != version) {
+        sweepEntries.clear();
+        sweepGroups.clear();
+
+        for(unsigned int i = 0; i < members.size(); i++) {
+            if(!members[i]) continue;
+
+            if(members[i]->entityType == FLX_GROUP) {
+                sweepGroups.push_back(members[i]);
+            }
+            else if(members[i]->entityType == FLX_OBJECT) {
+                SweepEntry entry;
+                entry.member = members[i];
+                sweepEntries.push_back(entry);
+            }
+        }
+
+        sweepVersion = version;
+        resort = true;
+    }
+
+    // refresh boxes and find axis with bigger spread of centers
+    float dt = FlxG::fixedTime;
+    double sum[2] = { 0, 0 }, squares[2] = { 0, 0 };
+
+    for(unsigned int i = 0; i < sweepEntries.size(); i++) {
+        FlxObject *obj = (FlxObject*) sweepEntries[i].member;
+        FlxBox& box = sweepEntries[i].box;
+
+        if(swept) {
+            getSweptBox(obj, dt, box);
+        }
+        else {
+            box.minX = obj->hitbox.x;
+            box.minY = obj->hitbox.y;
+            box.maxX = obj->hitbox.x + obj->hitbox.width;
+            box.maxY = obj->hitbox.y + obj->hitbox.height;
+        }
+
+        double centerX = (box.minX + box.maxX) * 0.5;
+        double centerY = (box.minY + box.maxY) * 0.5;
+
+        sum[0] += centerX;
+        sum[1] += centerY;
+        squares[0] += centerX * centerX;
+        squares[1] += centerY * centerY;
+    }
+
+    if(!sweepEntries.empty()) {
+        double count = sweepEntries.size();
+        double spread[2];
+
+        for(int a = 0; a < 2; a++) {
+            spread[a] = squares[a] / count - (sum[a] / count) * (sum[a] / count);
+        }
+
+        int axis = sweepAxis;
+
+        if(axis < 0) axis = (spread[1] > spread[0]) ? 1 : 0;
+        else if(spread[1 - axis] > spread[axis] * SweepAxisSwitchRatio) axis = 1 - axis;
+
+        if(axis != sweepAxis) {
+            sweepAxis = axis;
+            resort = true;
+        }
+    }
+    else if(sweepAxis < 0) {
+        sweepAxis = 0;
+    }
+
+    for(unsigned int i = 0; i < sweepEntries.size(); i++) {
+        SweepEntry& entry = sweepEntries[i];
+        entry.min = (sweepAxis == 0) ? entry.box.minX : entry.box.minY;
+        entry.max = (sweepAxis == 0) ? entry.box.maxX : entry.box.maxY;
+    }
+
+    if(resort) {
+        std::sort(sweepEntries.begin(), sweepEntries.end(), [](const SweepEntry& a, const SweepEntry& b) {
+            return a.min < b.min;
+        });
+    }
+    else {
+        for(unsigned int i = 1; i < sweepEntries.size(); i++) {
+            if(sweepEntries[i - 1].min <= sweepEntries[i].min) continue;
+
+            SweepEntry entry = sweepEntries[i];
+            unsigned int j = i;
+
+            while(j > 0 && sweepEntries[j - 1].min > entry.min) {
+                sweepEntries[j] = sweepEntries[j - 1];
+                j--;
             }
+
+            sweepEntries[j] = entry;
+        }
+    }
+
+    sweeping = true;
+    unsigned int startVersion = version;
+
+    // members removed by callbacks aren't deleted before compact(), so they are only skipped
+    auto check = [&](FlxBasic *first, FlxBasic *second) {
+        if(version != startVersion && (indexOf(first) < 0 || indexOf(second) < 0)) return;
+        visit(first, second);
+    };
+
+    for(unsigned int i = 0; i < sweepEntries.size(); i++) {
+        const SweepEntry& first = sweepEntries[i];
+        if(!first.member->alive) continue;
+
+        for(unsigned int j = i + 1; j < sweepEntries.size() && sweepEntries[j].min <= first.max; j++) {
+            const SweepEntry& second = sweepEntries[j];
+
+            if(second.member->alive && first.box.overlaps(second.box)) check(first.member, second.member);
+        }
+    }
+
+    // subgroups are checked against everything else (other subgroups once)
+    for(unsigned int i = 0; i < sweepGroups.size(); i++) {
+        FlxBasic *group = sweepGroups[i];
+        if(!group->alive) continue;
+
+        for(unsigned int j = 0; j < sweepEntries.size(); j++) {
+            if(sweepEntries[j].member->alive) check(group, sweepEntries[j].member);
+        }
+
+        for(unsigned int j = i + 1; j < sweepGroups.size(); j++) {
+            if(sweepGroups[j]->alive) check(group, sweepGroups[j]);
         }
     }
 
+    sweeping = false;
+}
+
+
+FlxGroup::EntitiesSet FlxGroup::selfOverlaps(const CollisionCallback& callback) {
+    FLX_PROFILE_ZONE("FlxGroup::selfOverlaps");
+
+    FlxGroup::EntitiesSet set = { 0, 0 };
+
+    sweepPairs(false, [&](FlxBasic *first, FlxBasic *second) {
+        if(first->overlaps(second)) {
+            set.first = first;
+            set.second = second;
+
+            if(callback != nullptr) callback(set.first, set.second);
+        }
+    });
+
     return set;
 }
 
 
 FlxGroup::EntitiesSet FlxGroup::selfCollide(const CollisionCallback& callback) {
+    FLX_PROFILE_ZONE("FlxGroup::selfCollide");
+
     FlxGroup::EntitiesSet set = { 0, 0 };
 
-    for(unsigned int i = 0; i < members.size(); i++) {
-        for(int j = members.size() - 1; j >= 0; j--) {
-            if((members[i] != members[j]) && members[i]->collide(members[j])) {
-                set.first = members[i];
-                set.second = members[j];
+    sweepPairs(true, [&](FlxBasic *first, FlxBasic *second) {
+        // collide() stops only the first object
+        bool hit = first->collide(second) != NULL;
+        if(second->collide(first)) hit = true;
 
-                if(callback != nullptr) callback(set.first, set.second);
-            }
+        if(hit) {
+            set.first = first;
+            set.second = second;
+
+            if(callback != nullptr) callback(set.first, set.second);
         }
-    }
+    });
 
     return set;
 }
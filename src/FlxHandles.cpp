@@ -0,0 +1,127 @@
+#include "FlxHandles.h"
+#include "FlxObject.h"
+#include "FlxGroup.h"
+
+// handle = slot index (low bits) + generation (high bits)
+static const unsigned int IndexBits = 22;
+static const unsigned int IndexMask = (1 << IndexBits) - 1;
+static const unsigned int GenerationMask = (1 << (32 - IndexBits)) - 1;
+
+// slots are allocated in pages, so pointers to them never move
+static const unsigned int PageBits = 12;
+static const unsigned int PageSize = 1 << PageBits;
+static const unsigned int MaxPages = (IndexMask + 1) / PageSize;
+
+// freed slots wait in FIFO queue until there are enough of them, so single slot is reused
+// (and its generation wraps) very rarely
+static const unsigned int MinFreeSlots = 1024;
+
+// all of it is constant-initialized, static entities (like FlxG::flashSprite) can be created
+// before main(). Pages are never freed, they are used until the very end of program.
+static FlxMutex SlotsMutex;
+static void *Pages[MaxPages];
+static std::atomic<unsigned int> SlotsCount(1);     // slot 0 is never used (FLX_NO_HANDLE)
+static unsigned int FreeHead = 0, FreeTail = 0, FreeCount = 0;
+static std::atomic<unsigned int> EntitiesCount(0);
+
+
+FlxHandles::Slot* FlxHandles::getSlot(unsigned int index) {
+    return &((Slot*) Pages[index >> PageBits])[index & (PageSize - 1)];
+}
+
+
+FlxHandle FlxHandles::create(FlxBasic *object) {
+    FlxLock lock(SlotsMutex);
+
+    unsigned int index;
+    unsigned int count = SlotsCount.load(std::memory_order_relaxed);
+
+    if(FreeCount > 0 && (FreeCount >= MinFreeSlots || count > IndexMask)) {
+        index = FreeHead;
+        FreeHead = getSlot(index)->nextFree;
+        FreeCount--;
+    }
+    else if(count <= IndexMask) {
+        index = count;
+
+        if((index & (PageSize - 1)) == 0 || index == 1) {
+            Pages[index >> PageBits] = new Slot[PageSize];
+        }
+
+        // resolving threads see the page before the slot
+        SlotsCount.store(count + 1, std::memory_order_release);
+    }
+    else {
+        std::cerr << "[Error] FlxHandles: Too many entities" << std::endl;
+        return FLX_NO_HANDLE;
+    }
+
+    // generation was changed by destroy(), readers which see new object see new generation too
+    Slot *slot = getSlot(index);
+    slot->object.store(object, std::memory_order_release);
+    EntitiesCount++;
+
+    return (slot->generation.load(std::memory_order_relaxed) << IndexBits) | index;
+}
+
+
+void FlxHandles::destroy(FlxHandle handle) {
+    FlxLock lock(SlotsMutex);
+
+    unsigned int index = handle & IndexMask;
+    if(index == 0 || index >= SlotsCount.load(std::memory_order_relaxed)) return;
+
+    Slot *slot = getSlot(index);
+    unsigned int generation = slot->generation.load(std::memory_order_relaxed);
+    if(!slot->object.load(std::memory_order_relaxed) || generation != (handle >> IndexBits)) return;
+
+    slot->object.store(NULL, std::memory_order_release);
+    slot->generation.store((generation + 1) & GenerationMask, std::memory_order_release);
+    slot->nextFree = 0;
+
+    if(FreeCount == 0) FreeHead = index;
+    else getSlot(FreeTail)->nextFree = index;
+
+    FreeTail = index;
+    FreeCount++;
+    EntitiesCount--;
+}
+
+
+FlxBasic* FlxHandles::resolve(FlxHandle handle) {
+    unsigned int index = handle & IndexMask;
+    if(index == 0 || index >= SlotsCount.load(std::memory_order_acquire)) return NULL;
+
+    // slot can be destroyed and reused meanwhile, so generation is checked again after object
+    // is read (object belongs to handle only if generation didn't change)
+    Slot *slot = getSlot(index);
+    unsigned int generation = handle >> IndexBits;
+    if(slot->generation.load(std::memory_order_acquire) != generation) return NULL;
+
+    FlxBasic *object = slot->object.load(std::memory_order_acquire);
+    if(slot->generation.load(std::memory_order_acquire) != generation) return NULL;
+
+    return object;
+}
+
+
+FlxObject* FlxHandles::getObject(FlxHandle handle) {
+    FlxBasic *basic = resolve(handle);
+    return (basic && basic->entityType == FLX_OBJECT) ? (FlxObject*) basic : NULL;
+}
+
+
+FlxGroup* FlxHandles::getGroup(FlxHandle handle) {
+    FlxBasic *basic = resolve(handle);
+    return (basic && basic->entityType == FLX_GROUP) ? (FlxGroup*) basic : NULL;
+}
+
+
+bool FlxHandles::isValid(FlxHandle handle) {
+    return resolve(handle) != NULL;
+}
+
+
+unsigned int FlxHandles::getCount() {
+    return EntitiesCount;
+}
@@ -0,0 +1,358 @@
+#include "FlxJobs.h"
+#include "FlxProfiler.h"
+
+/*
+*  Single scheduled job
+*/
+struct FlxJob {
+    FlxJobs::Task task;
+
+    // unfinished dependencies (+1 while job is being added)
+    std::atomic<int> dependencies;
+    std::atomic<bool> done;
+
+    // jobs waiting for this one (guarded by mutex)
+    FlxMutex mutex;
+    std::vector<FlxJobHandle> dependents;
+};
+
+// queue owned by current thread (-1 = thread isn't part of jobs system)
+static FLX_THREAD_LOCAL FlxJobs *CurrentJobs = NULL;
+static FLX_THREAD_LOCAL int CurrentQueue = -1;
+
+
+FlxJobs::FlxJobs() : queuedJobs(0), nextQueue(0), running(false) {
+    initialized = false;
+}
+
+
+FlxJobs::~FlxJobs() {
+    shutdown();
+}
+
+
+void FlxJobs::init(int workers) {
+    if(initialized) shutdown();
+
+    #ifndef FLX_NO_THREADS
+    if(workers < 0) {
+        workers = (int)std::thread::hardware_concurrency() - 1;
+        if(workers < 0) workers = 0;
+    }
+    #else
+    workers = 0;
+    #endif
+
+    initialized = true;
+    running = true;
+
+    CurrentJobs = this;
+    CurrentQueue = 0;
+
+    // without workers every job is run immediately
+    if(workers == 0) return;
+
+    for(int i = 0; i <= workers; i++) {
+        queues.push_back(new Queue());
+    }
+
+    #ifndef FLX_NO_THREADS
+    for(int i = 1; i <= workers; i++) {
+        threads.push_back(new std::thread(&FlxJobs::workerLoop, this, i));
+    }
+    #endif
+}
+
+
+void FlxJobs::shutdown() {
+    if(!initialized) return;
+
+    running = false;
+
+    #ifndef FLX_NO_THREADS
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeUp.notify_all();
+
+    for(unsigned int i = 0; i < threads.size(); i++) {
+        threads[i]->join();
+        delete threads[i];
+    }
+
+    threads.clear();
+    #endif
+
+    // finish what's left (including dependents of these jobs)
+    for(;;) {
+        FlxJobHandle job = pop(0);
+        if(!job) break;
+
+        execute(job);
+    }
+
+    for(unsigned int i = 0; i < queues.size(); i++) {
+        delete queues[i];
+    }
+
+    queues.clear();
+    queuedJobs = 0;
+    initialized = false;
+
+    if(CurrentJobs == this) {
+        CurrentJobs = NULL;
+        CurrentQueue = -1;
+    }
+}
+
+
+bool FlxJobs::isInitialized() {
+    return initialized;
+}
+
+
+unsigned int FlxJobs::getWorkersCount() {
+    return queues.empty() ? 0 : queues.size() - 1;
+}
+
+
+FlxJobHandle FlxJobs::add(const Task& task) {
+    return add(task, std::vector<FlxJobHandle>());
+}
+
+
+FlxJobHandle FlxJobs::add(const Task& task, const FlxJobHandle& dependency) {
+    std::vector<FlxJobHandle> dependencies;
+    if(dependency) dependencies.push_back(dependency);
+
+    return add(task, dependencies);
+}
+
+
+FlxJobHandle FlxJobs::add(const Task& task, const std::vector<FlxJobHandle>& dependencies) {
+    FlxJobHandle job = std::make_shared<FlxJob>();
+    job->task = task;
+    job->dependencies = 1;
+    job->done = false;
+
+    for(unsigned int i = 0; i < dependencies.size(); i++) {
+        FlxJob *dependency = dependencies[i].get();
+        if(!dependency) continue;
+
+        FlxLock lock(dependency->mutex);
+
+        if(!dependency->done) {
+            job->dependencies++;
+            dependency->dependents.push_back(job);
+        }
+    }
+
+    if(--job->dependencies == 0) schedule(job);
+    return job;
+}
+
+
+bool FlxJobs::isDone(const FlxJobHandle& job) {
+    return !job || job->done;
+}
+
+
+void FlxJobs::wait(const FlxJobHandle& job) {
+    if(!job) return;
+
+    int index = (CurrentJobs == this) ? CurrentQueue : -1;
+
+    while(!job->done) {
+        FlxJobHandle other = pop(index);
+
+        if(other) {
+            execute(other);
+        }
+        else {
+            #ifndef FLX_NO_THREADS
+            std::this_thread::yield();
+            #endif
+        }
+    }
+}
+
+
+void FlxJobs::parallelFor(unsigned int begin, unsigned int end, const RangeTask& task, unsigned int grain) {
+    if(begin >= end) return;
+
+    unsigned int count = end - begin;
+    unsigned int workers = getWorkersCount();
+
+    // few chunks per thread, so slower chunks can be balanced
+    if(grain == 0) grain = count / ((workers + 1) * 4);
+    if(grain == 0) grain = 1;
+
+    if(workers == 0 || count <= grain) {
+        task(begin, end);
+        return;
+    }
+
+    // every thread takes next chunk until whole range is done
+    std::atomic<unsigned int> next(begin);
+
+    Task runChunks = [&]() {
+        for(;;) {
+            unsigned int first = next.fetch_add(grain);
+            if(first >= end || first < begin) break;
+
+            unsigned int last = (end - first > grain) ? first + grain : end;
+            task(first, last);
+        }
+    };
+
+    unsigned int chunks = (count + grain - 1) / grain;
+    unsigned int helpersCount = (chunks - 1 < workers) ? chunks - 1 : workers;
+
+    std::vector<FlxJobHandle> helpers;
+    for(unsigned int i = 0; i < helpersCount; i++) {
+        helpers.push_back(add(runChunks));
+    }
+
+    runChunks();
+
+    // helpers reference local variables, so they must finish before return
+    for(unsigned int i = 0; i < helpers.size(); i++) {
+        wait(helpers[i]);
+    }
+}
+
+
+void FlxJobs::runOnMainThread(const Task& task) {
+    FlxLock lock(mainThreadMutex);
+    mainThreadTasks.push_back(task);
+}
+
+
+void FlxJobs::update() {
+    std::vector<Task> tasks;
+
+    {
+        FlxLock lock(mainThreadMutex);
+        tasks.swap(mainThreadTasks);
+    }
+
+    for(unsigned int i = 0; i < tasks.size(); i++) {
+        tasks[i]();
+    }
+}
+
+
+void FlxJobs::schedule(const FlxJobHandle& job) {
+    if(queues.empty()) {
+        execute(job);
+    }
+    else {
+        push(job);
+    }
+}
+
+
+void FlxJobs::push(const FlxJobHandle& job) {
+    int index = (CurrentJobs == this) ? CurrentQueue : -1;
+
+    // threads outside jobs system spread jobs over all queues
+    if(index < 0 || index >= (int)queues.size()) {
+        index = nextQueue++ % queues.size();
+    }
+
+    {
+        FlxLock lock(queues[index]->mutex);
+        queues[index]->jobs.push_back(job);
+    }
+
+    queuedJobs++;
+
+    #ifndef FLX_NO_THREADS
+    {
+        // don't notify worker which is just going to sleep
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeUp.notify_one();
+    #endif
+}
+
+
+FlxJobHandle FlxJobs::pop(int index) {
+    if(queuedJobs <= 0 || queues.empty()) return FlxJobHandle();
+
+    // own queue first (the newest job, its data is still in cache)
+    if(index >= 0 && index < (int)queues.size()) {
+        Queue *queue = queues[index];
+        FlxLock lock(queue->mutex);
+
+        if(!queue->jobs.empty()) {
+            FlxJobHandle job = queue->jobs.back();
+            queue->jobs.pop_back();
+            queuedJobs--;
+            return job;
+        }
+    }
+
+    // steal the oldest job from other queue
+    unsigned int start = (index >= 0) ? index + 1 : 0;
+
+    for(unsigned int i = 0; i < queues.size(); i++) {
+        unsigned int victim = (start + i) % queues.size();
+        if((int)victim == index) continue;
+
+        Queue *queue = queues[victim];
+        FlxLock lock(queue->mutex);
+
+        if(!queue->jobs.empty()) {
+            FlxJobHandle job = queue->jobs.front();
+            queue->jobs.pop_front();
+            queuedJobs--;
+            return job;
+        }
+    }
+
+    return FlxJobHandle();
+}
+
+
+void FlxJobs::execute(const FlxJobHandle& job) {
+    {
+        FLX_PROFILE_ZONE("Job");
+        job->task();
+    }
+
+    std::vector<FlxJobHandle> dependents;
+
+    {
+        FlxLock lock(job->mutex);
+        job->done = true;
+        dependents.swap(job->dependents);
+    }
+
+    for(unsigned int i = 0; i < dependents.size(); i++) {
+        if(--dependents[i]->dependencies == 0) schedule(dependents[i]);
+    }
+}
+
+
+void FlxJobs::workerLoop(unsigned int index) {
+    #ifndef FLX_NO_THREADS
+    CurrentJobs = this;
+    CurrentQueue = index;
+
+    while(running) {
+        FlxJobHandle job = pop(index);
+
+        if(job) {
+            execute(job);
+        }
+        else {
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wakeUp.wait(lock, [this]() { return queuedJobs > 0 || !running; });
+        }
+    }
+
+    CurrentJobs = NULL;
+    CurrentQueue = -1;
+    #endif
+}
@@ -0,0 +1,218 @@
+#include "FlxKinematics.h"
+
+#ifdef FLX_AVX
+    #include <immintrin.h>
+
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+// elements are padded to the widest kernel (8 floats) and aligned to 32 bytes
+static const unsigned int Padding = 8;
+
+// selected before main(), so worker threads never race on it
+FlxKinematics::Kernel FlxKinematics::kernel = FlxKinematics::selectKernel();
+
+
+#ifdef FLX_AVX
+/*
+*  Is AVX supported by CPU and enabled by OS?
+*/
+static bool detectAvx() {
+    unsigned int ecx;
+
+    #ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    ecx = (unsigned int)info[2];
+    #else
+    unsigned int eax, ebx, edx;
+    if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return false;
+    #endif
+
+    // AVX and OSXSAVE bits
+    if((ecx & (1 << 28)) == 0 || (ecx & (1 << 27)) == 0) return false;
+
+    // OS saves XMM and YMM registers
+    unsigned long long xcr0;
+
+    #ifdef _MSC_VER
+    xcr0 = _xgetbv(0);
+    #else
+    unsigned int lo, hi;
+    __asm__ __volatile__(".byte 0x0f, 0x01, 0xd0" : "=a"(lo), "=d"(hi) : "c"(0));
+    xcr0 = ((unsigned long long)hi << 32) | lo;
+    #endif
+
+    return (xcr0 & 6) == 6;
+}
+#endif
+
+
+static void integrateScalar(float * const *f, unsigned int begin, unsigned int end, float dt) {
+    for(unsigned int i = begin; i < end; i++) {
+        f[FlxKinematics::X][i] += f[FlxKinematics::VELOCITY_X][i] * dt;
+        f[FlxKinematics::Y][i] += f[FlxKinematics::VELOCITY_Y][i] * dt;
+
+        float vx = f[FlxKinematics::VELOCITY_X][i] + f[FlxKinematics::ACCELERATION_X][i] * dt;
+        float vy = f[FlxKinematics::VELOCITY_Y][i] + f[FlxKinematics::ACCELERATION_Y][i] * dt;
+        float mx = f[FlxKinematics::MAX_VELOCITY_X][i];
+        float my = f[FlxKinematics::MAX_VELOCITY_Y][i];
+
+        if(vx > mx) vx = mx;
+        if(vy > my) vy = my;
+        if(vx < -mx) vx = -mx;
+        if(vy < -my) vy = -my;
+
+        f[FlxKinematics::VELOCITY_X][i] = vx;
+        f[FlxKinematics::VELOCITY_Y][i] = vy;
+        f[FlxKinematics::ANGLE][i] += f[FlxKinematics::ANGULAR_VELOCITY][i] * dt;
+    }
+}
+
+
+#ifdef FLX_SSE
+static void integrateSse(float * const *f, unsigned int count, float dt) {
+    __m128 dt4 = _mm_set1_ps(dt);
+    __m128 sign = _mm_set1_ps(-0.f);
+
+    for(unsigned int i = 0; i < count; i += 4) {
+        __m128 vx = _mm_load_ps(f[FlxKinematics::VELOCITY_X] + i);
+        __m128 vy = _mm_load_ps(f[FlxKinematics::VELOCITY_Y] + i);
+
+        _mm_store_ps(f[FlxKinematics::X] + i, _mm_add_ps(_mm_load_ps(f[FlxKinematics::X] + i), _mm_mul_ps(vx, dt4)));
+        _mm_store_ps(f[FlxKinematics::Y] + i, _mm_add_ps(_mm_load_ps(f[FlxKinematics::Y] + i), _mm_mul_ps(vy, dt4)));
+
+        vx = _mm_add_ps(vx, _mm_mul_ps(_mm_load_ps(f[FlxKinematics::ACCELERATION_X] + i), dt4));
+        vy = _mm_add_ps(vy, _mm_mul_ps(_mm_load_ps(f[FlxKinematics::ACCELERATION_Y] + i), dt4));
+
+        // clamp to [-max, max] (upper bound first, like FlxObject::update)
+        __m128 mx = _mm_load_ps(f[FlxKinematics::MAX_VELOCITY_X] + i);
+        __m128 my = _mm_load_ps(f[FlxKinematics::MAX_VELOCITY_Y] + i);
+        vx = _mm_max_ps(_mm_min_ps(vx, mx), _mm_xor_ps(mx, sign));
+        vy = _mm_max_ps(_mm_min_ps(vy, my), _mm_xor_ps(my, sign));
+
+        _mm_store_ps(f[FlxKinematics::VELOCITY_X] + i, vx);
+        _mm_store_ps(f[FlxKinematics::VELOCITY_Y] + i, vy);
+
+        __m128 av = _mm_load_ps(f[FlxKinematics::ANGULAR_VELOCITY] + i);
+        _mm_store_ps(f[FlxKinematics::ANGLE] + i, _mm_add_ps(_mm_load_ps(f[FlxKinematics::ANGLE] + i), _mm_mul_ps(av, dt4)));
+    }
+}
+#endif
+
+
+#ifdef FLX_AVX
+FLX_AVX_FUNCTION static void integrateAvx(float * const *f, unsigned int count, float dt) {
+    __m256 dt8 = _mm256_set1_ps(dt);
+    __m256 sign = _mm256_set1_ps(-0.f);
+
+    for(unsigned int i = 0; i < count; i += 8) {
+        __m256 vx = _mm256_load_ps(f[FlxKinematics::VELOCITY_X] + i);
+        __m256 vy = _mm256_load_ps(f[FlxKinematics::VELOCITY_Y] + i);
+
+        _mm256_store_ps(f[FlxKinematics::X] + i, _mm256_add_ps(_mm256_load_ps(f[FlxKinematics::X] + i), _mm256_mul_ps(vx, dt8)));
+        _mm256_store_ps(f[FlxKinematics::Y] + i, _mm256_add_ps(_mm256_load_ps(f[FlxKinematics::Y] + i), _mm256_mul_ps(vy, dt8)));
+
+        vx = _mm256_add_ps(vx, _mm256_mul_ps(_mm256_load_ps(f[FlxKinematics::ACCELERATION_X] + i), dt8));
+        vy = _mm256_add_ps(vy, _mm256_mul_ps(_mm256_load_ps(f[FlxKinematics::ACCELERATION_Y] + i), dt8));
+
+        __m256 mx = _mm256_load_ps(f[FlxKinematics::MAX_VELOCITY_X] + i);
+        __m256 my = _mm256_load_ps(f[FlxKinematics::MAX_VELOCITY_Y] + i);
+        vx = _mm256_max_ps(_mm256_min_ps(vx, mx), _mm256_xor_ps(mx, sign));
+        vy = _mm256_max_ps(_mm256_min_ps(vy, my), _mm256_xor_ps(my, sign));
+
+        _mm256_store_ps(f[FlxKinematics::VELOCITY_X] + i, vx);
+        _mm256_store_ps(f[FlxKinematics::VELOCITY_Y] + i, vy);
+
+        __m256 av = _mm256_load_ps(f[FlxKinematics::ANGULAR_VELOCITY] + i);
+        _mm256_store_ps(f[FlxKinematics::ANGLE] + i, _mm256_add_ps(_mm256_load_ps(f[FlxKinematics::ANGLE] + i), _mm256_mul_ps(av, dt8)));
+    }
+
+    _mm256_zeroupper();
+}
+#endif
+
+
+void FlxKinematics::integrate(float * const *fields, unsigned int count, float dt) {
+    if(count == 0) return;
+
+    Kernel k = getKernel();
+    unsigned int padded = (count + Padding - 1) / Padding * Padding;
+
+    #ifdef FLX_AVX
+    if(k == AVX) {
+        integrateAvx(fields, padded, dt);
+        return;
+    }
+    #endif
+
+    #ifdef FLX_SSE
+    if(k == SSE) {
+        integrateSse(fields, padded, dt);
+        return;
+    }
+    #endif
+
+    (void)k; (void)padded;
+    integrateScalar(fields, 0, count, dt);
+}
+
+
+FlxKinematics::Kernel FlxKinematics::selectKernel() {
+    if(isSupported(AVX)) return AVX;
+    if(isSupported(SSE)) return SSE;
+    return SCALAR;
+}
+
+
+FlxKinematics::Kernel FlxKinematics::getKernel() {
+    return kernel;
+}
+
+
+bool FlxKinematics::setKernel(Kernel k) {
+    if(!isSupported(k)) return false;
+
+    kernel = k;
+    return true;
+}
+
+
+bool FlxKinematics::isSupported(Kernel k) {
+    switch(k) {
+        case SCALAR:
+            return true;
+
+        case SSE:
+            #ifdef FLX_SSE
+            return true;
+            #else
+            return false;
+            #endif
+
+        case AVX:
+            #ifdef FLX_AVX
+            {
+                static bool avx = detectAvx();
+                return avx;
+            }
+            #else
+            return false;
+            #endif
+    }
+
+    return false;
+}
+
+
+const char* FlxKinematics::getKernelName(Kernel k) {
+    switch(k) {
+        case SSE: return "SSE";
+        case AVX: return "AVX";
+        default: return "Scalar";
+    }
+}
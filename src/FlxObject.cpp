@@ -7,7 +7,9 @@ FlxObject::FlxObject() {
     collisions = true;
 
     visible = true;
-    x = y = angle = angularVelocity = 0.f;
+    x = y = z = angle = angularVelocity = 0.f;
+    lastAngle = 0.f;
+    lastUpdate = 0;
     width = height = 0;
     color = 0xffffff;
     alpha = 1.0f;
@@ -35,6 +37,12 @@ void FlxObject::update() {
 
     float dt = FlxG::fixedTime;
 
+    // remember previous state for render interpolation
+    last.x = x;
+    last.y = y;
+    lastAngle = angle;
+    lastUpdate = FlxG::updatesCount;
+
     if(!isFollowingPath) {
         x += velocity.x * dt;
         y += velocity.y * dt;
@@ -78,12 +86,47 @@ FlxVector FlxObject::getCenter() {
 }
 
 
+FlxVector FlxObject::getDrawPosition() {
+
+    // objects not updated in last step are standing still
+    if(!FlxG::interpolation || lastUpdate != FlxG::updatesCount) return FlxVector(x, y);
+
+    float alpha = FlxG::interpolationAlpha;
+    return FlxVector(last.x + (x - last.x) * alpha, last.y + (y - last.y) * alpha);
+}
+
+
+float FlxObject::getDrawAngle() {
+    if(!FlxG::interpolation || lastUpdate != FlxG::updatesCount) return angle;
+
+    return lastAngle + (angle - lastAngle) * FlxG::interpolationAlpha;
+}
+
+
+const void* FlxObject::getTextureKey() {
+    return NULL;
+}
+
+
+void FlxObject::resetInterpolation() {
+    last.x = x;
+    last.y = y;
+    lastAngle = angle;
+}
+
+
 void FlxObject::kill() {
     visible = false;
     FlxBasic::kill();
 }
 
 
+void FlxObject::revive() {
+    visible = true;
+    FlxBasic::revive();
+}
+
+
 bool FlxObject::isTouchingFloor(FlxBasic *floor) {
 
     FlxObject obj1;
@@ -142,8 +185,11 @@ bool FlxObject::isTouchingCeiling(FlxBasic *ceil) {
 
 FlxBasic* FlxObject::overlaps(FlxBasic *object, const CollisionCallback& callback) {
 
+    if(!object || !alive) return NULL;
+
     if(object->entityType == FLX_OBJECT) {
         FlxObject *obj = (FlxObject*)object;
+        if(!obj->alive) return NULL;
 
         if(hitbox.overlaps(obj->hitbox)) {
             if(callback != nullptr) callback(this, object);
@@ -154,12 +200,21 @@ FlxBasic* FlxObject::overlaps(FlxBasic *object, const CollisionCallback& callbac
         FlxGroup *group = (FlxGroup*) object;
         FlxBasic *mem = NULL;
 
-        for(unsigned int i = 0; i < group->members.size(); i++) {
-            FlxBasic *obj = overlaps(group->members[i]);
+        auto test = [&](FlxBasic *member) {
+            FlxBasic *obj = overlaps(member);
             if(obj != NULL) {
-                if(callback != nullptr) callback(this, group->members[i]);
+                if(callback != nullptr) callback(this, member);
                 mem = obj;
             }
+        };
+
+        if(group->checkObject(this, false, callback, mem)) return mem;
+
+        FlxBox area = { hitbox.x, hitbox.y, hitbox.x + hitbox.width, hitbox.y + hitbox.height };
+        if(group->queryBroadphase(area, test)) return mem;
+
+        for(unsigned int i = 0; i < group->members.size(); i++) {
+            test(group->members[i]);
         }
 
         return mem;
@@ -171,14 +226,14 @@ FlxBasic* FlxObject::overlaps(FlxBasic *object, const CollisionCallback& callbac
 
 FlxBasic* FlxObject::collide(FlxBasic *object, const CollisionCallback& callback) {
 
-    if(!collisions) return NULL;
+    if(!object || !collisions || !alive) return NULL;
 
     if(object->entityType == FLX_OBJECT) {
         bool col = false;
         FlxObject *obj = (FlxObject*) object;
         float dt = FlxG::fixedTime;
 
-        if(!obj->collisions) return NULL;
+        if(!obj->collisions || !obj->alive) return NULL;
 
         // x-axis
         FlxRect rect1;
@@ -223,8 +278,25 @@ FlxBasic* FlxObject::collide(FlxBasic *object, const CollisionCallback& callback
         FlxGroup *group = (FlxGroup*) object;
         FlxBasic *ent = 0;
 
+        auto test = [&](FlxBasic *member) {
+            FlxBasic *hit = collide(member, callback);
+            if(hit) ent = hit;
+        };
+
+        if(group->checkObject(this, true, callback, ent)) return ent;
+
+        // everything this object passes through in one step
+        float dt = FlxG::fixedTime;
+        FlxBox area;
+        area.minX = hitbox.x + std::min(velocity.x * dt, 0.f);
+        area.minY = hitbox.y + std::min(velocity.y * dt, 0.f);
+        area.maxX = hitbox.x + hitbox.width + std::max(velocity.x * dt, 0.f);
+        area.maxY = hitbox.y + hitbox.height + std::max(velocity.y * dt, 0.f);
+
+        if(group->queryBroadphase(area, test)) return ent;
+
         for(int i = group->members.size() - 1; i >= 0; i--) {
-            ent = collide(group->members[i], callback);
+            test(group->members[i]);
         }
 
         return ent;
@@ -0,0 +1,228 @@
+#include "FlxProfiler.h"
+#include "FlxG.h"
+#include <chrono>
+
+#define FLX_PROFILER_MAX_DEPTH 64
+
+/*
+*  Zones recorded by single thread
+*/
+struct FlxProfilerThread {
+    unsigned int id;
+    std::string name;
+
+    // ring buffer of finished zones (locked by its own thread and by exporter only)
+    FlxMutex mutex;
+    std::vector<FlxProfilerZone> zones;
+    unsigned int head;
+    unsigned long long written;
+
+    // opened zones
+    const char *stackNames[FLX_PROFILER_MAX_DEPTH];
+    unsigned long long stackStart[FLX_PROFILER_MAX_DEPTH];
+    unsigned int depth;
+};
+
+static FlxMutex ThreadsMutex;
+static std::vector<FlxProfilerThread*> Threads;
+static FLX_THREAD_LOCAL FlxProfilerThread *CurrentThread = NULL;
+static unsigned int BufferSize = 65536;
+
+static std::atomic<unsigned int> Frame(0);
+static std::string CapturePath;
+static unsigned int CaptureFrame = 0;
+
+static std::chrono::high_resolution_clock::time_point StartTime = std::chrono::high_resolution_clock::now();
+
+bool FlxProfiler::enabled = false;
+
+
+static FlxProfilerThread* getThread() {
+    if(CurrentThread) return CurrentThread;
+
+    FlxProfilerThread *thread = new FlxProfilerThread();
+    thread->head = 0;
+    thread->written = 0;
+    thread->depth = 0;
+
+    FlxLock lock(ThreadsMutex);
+    thread->zones.resize(BufferSize);
+    thread->id = Threads.size() + 1;
+    thread->name = "Thread " + FlxU::toString((int)thread->id);
+    Threads.push_back(thread);
+
+    CurrentThread = thread;
+    return thread;
+}
+
+
+void FlxProfiler::beginZone(const char *name) {
+    FlxProfilerThread *thread = getThread();
+
+    if(thread->depth < FLX_PROFILER_MAX_DEPTH) {
+        thread->stackNames[thread->depth] = name;
+        thread->stackStart[thread->depth] = getTime();
+    }
+
+    thread->depth++;
+}
+
+
+void FlxProfiler::endZone() {
+    FlxProfilerThread *thread = getThread();
+    if(thread->depth == 0) return;
+
+    thread->depth--;
+
+    // too deep zones are counted, but not recorded
+    if(thread->depth >= FLX_PROFILER_MAX_DEPTH || thread->zones.empty()) return;
+
+    unsigned long long end = getTime();
+    FlxLock lock(thread->mutex);
+
+    FlxProfilerZone& zone = thread->zones[thread->head];
+    zone.name = thread->stackNames[thread->depth];
+    zone.start = thread->stackStart[thread->depth];
+    zone.end = end;
+    zone.frame = Frame.load(std::memory_order_relaxed);
+    zone.depth = thread->depth;
+
+    thread->head = (thread->head + 1) % thread->zones.size();
+    thread->written++;
+}
+
+
+void FlxProfiler::frameMark() {
+    unsigned int finished = Frame++;
+
+    if(!CapturePath.empty() && finished >= CaptureFrame) {
+        exportTrace(CapturePath.c_str(), 1);
+        CapturePath.clear();
+    }
+}
+
+
+unsigned int FlxProfiler::getFrame() {
+    return Frame.load();
+}
+
+
+unsigned long long FlxProfiler::getTime() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::high_resolution_clock::now() - StartTime).count();
+}
+
+
+void FlxProfiler::setThreadName(const char *name) {
+    FlxProfilerThread *thread = getThread();
+
+    FlxLock lock(ThreadsMutex);
+    thread->name = name;
+}
+
+
+void FlxProfiler::setBufferSize(unsigned int zones) {
+    FlxLock lock(ThreadsMutex);
+    BufferSize = zones;
+}
+
+
+void FlxProfiler::clear() {
+    FlxLock lock(ThreadsMutex);
+
+    for(unsigned int i = 0; i < Threads.size(); i++) {
+        FlxLock threadLock(Threads[i]->mutex);
+        Threads[i]->head = 0;
+        Threads[i]->written = 0;
+    }
+}
+
+
+static void writeJsonString(std::stringstream& ss, const std::string& str) {
+    ss << '"';
+
+    for(unsigned int i = 0; i < str.size(); i++) {
+        if(str[i] == '"' || str[i] == '\\') ss << '\\';
+        ss << str[i];
+    }
+
+    ss << '"';
+}
+
+
+bool FlxProfiler::exportTrace(const char *path, unsigned int frames) {
+    if(!FlxG::backend) return false;
+
+    unsigned int current = Frame.load();
+    unsigned int firstFrame = (frames && frames < current) ? current - frames : 0;
+
+    std::stringstream ss;
+    ss.setf(std::ios::fixed);
+    ss.precision(3);
+    ss << "{\"traceEvents\":[";
+
+    bool first = true;
+    std::vector<FlxProfilerZone> zones;
+    FlxLock lock(ThreadsMutex);
+
+    for(unsigned int i = 0; i < Threads.size(); i++) {
+        FlxProfilerThread *thread = Threads[i];
+
+        if(!first) ss << ",";
+        ss << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->id;
+        ss << ",\"args\":{\"name\":";
+        writeJsonString(ss, thread->name);
+        ss << "}}";
+        first = false;
+
+        // copy zones of finished frames, so recording thread waits only for copying
+        zones.clear();
+
+        {
+            FlxLock threadLock(thread->mutex);
+
+            unsigned int size = thread->zones.size();
+            unsigned int count = thread->written < size ? (unsigned int)thread->written : size;
+            unsigned int start = size ? (thread->head + size - count) % size : 0;
+
+            for(unsigned int j = 0; j < count; j++) {
+                const FlxProfilerZone& zone = thread->zones[(start + j) % size];
+                if(zone.frame >= firstFrame && (!frames || zone.frame < current)) zones.push_back(zone);
+            }
+        }
+
+        for(unsigned int j = 0; j < zones.size(); j++) {
+            const FlxProfilerZone& zone = zones[j];
+
+            ss << ",\n{\"name\":";
+            writeJsonString(ss, zone.name);
+            ss << ",\"cat\":\"flixel\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->id;
+            ss << ",\"ts\":" << zone.start / 1000.0 << ",\"dur\":" << (zone.end - zone.start) / 1000.0;
+            ss << ",\"args\":{\"frame\":" << zone.frame << ",\"depth\":" << zone.depth << "}}";
+        }
+    }
+
+    ss << "\n],\"displayTimeUnit\":\"ns\"}\n";
+
+    FlxBackendFile *file = FlxG::backend->openFile(path, "wb", false);
+    if(!file) {
+        std::cerr << "[Error] Cannot save profiler trace to " << path << std::endl;
+        return false;
+    }
+
+    std::string data = ss.str();
+    file->write(data.data(), data.size());
+
+    file->close();
+    delete file;
+    return true;
+}
+
+
+void FlxProfiler::captureFrame(const char *path) {
+    enabled = true;
+    CapturePath = path;
+
+    // current frame could be recorded only partially
+    CaptureFrame = Frame.load() + 1;
+}
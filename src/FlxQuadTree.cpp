@@ -0,0 +1,159 @@
+#include "FlxQuadTree.h"
+
+
+FlxQuadTree::FlxQuadTree() {
+    FlxBox area = { 0.f, 0.f, 1024.f, 1024.f };
+    setBounds(area);
+}
+
+
+void FlxQuadTree::setBounds(const FlxBox& area, unsigned int maxDepth) {
+    float size = std::max(area.maxX - area.minX, area.maxY - area.minY);
+    if(!(size >= 1.f)) size = 1.f;
+
+    bounds.minX = area.minX;
+    bounds.minY = area.minY;
+    bounds.maxX = area.minX + size;
+    bounds.maxY = area.minY + size;
+
+    depthLimit = (maxDepth < MaxDepth) ? maxDepth : MaxDepth;
+    clear();
+}
+
+
+void FlxQuadTree::clear() {
+    nodes.clear();
+    items.clear();
+    freeItems.clear();
+    itemsCount = 0;
+
+    createNode(bounds.minX, bounds.minY, bounds.maxX - bounds.minX, 0, -1);
+}
+
+
+int FlxQuadTree::createNode(float minX, float minY, float size, unsigned int depth, int parent) {
+    Node node;
+    node.minX = minX;
+    node.minY = minY;
+    node.size = size;
+    node.depth = depth;
+    node.parent = parent;
+    node.children[0] = node.children[1] = node.children[2] = node.children[3] = -1;
+    node.firstItem = -1;
+    node.count = 0;
+
+    nodes.push_back(node);
+    return nodes.size() - 1;
+}
+
+
+int FlxQuadTree::findNode(const FlxBox& box) {
+    float centerX = (box.minX + box.maxX) * 0.5f;
+    float centerY = (box.minY + box.maxY) * 0.5f;
+    float extent = std::max(box.maxX - box.minX, box.maxY - box.minY);
+
+    // outside of tree (or NaN)
+    if(!(centerX >= bounds.minX && centerX <= bounds.maxX && centerY >= bounds.minY && centerY <= bounds.maxY)) return 0;
+
+    int current = 0;
+
+    while(nodes[current].depth < depthLimit) {
+        float half = nodes[current].size * 0.5f;
+        if(extent > half) break;
+
+        int quadrant = (centerX >= nodes[current].minX + half ? 1 : 0) + (centerY >= nodes[current].minY + half ? 2 : 0);
+        int child = nodes[current].children[quadrant];
+
+        if(child < 0) {
+            // nodes may be reallocated, so nothing is kept by reference here
+            child = createNode(nodes[current].minX + ((quadrant & 1) ? half : 0.f),
+                               nodes[current].minY + ((quadrant & 2) ? half : 0.f),
+                               half, nodes[current].depth + 1, current);
+            nodes[current].children[quadrant] = child;
+        }
+
+        current = child;
+    }
+
+    return current;
+}
+
+
+void FlxQuadTree::link(unsigned int id, int node) {
+    Item& item = items[id];
+    item.node = node;
+    item.prev = -1;
+    item.next = nodes[node].firstItem;
+
+    if(item.next >= 0) items[item.next].prev = id;
+    nodes[node].firstItem = id;
+
+    for(int n = node; n >= 0; n = nodes[n].parent) nodes[n].count++;
+}
+
+
+void FlxQuadTree::unlink(unsigned int id) {
+    Item& item = items[id];
+
+    if(item.prev >= 0) items[item.prev].next = item.next;
+    else nodes[item.node].firstItem = item.next;
+
+    if(item.next >= 0) items[item.next].prev = item.prev;
+
+    for(int n = item.node; n >= 0; n = nodes[n].parent) nodes[n].count--;
+    item.node = -1;
+}
+
+
+unsigned int FlxQuadTree::insert(const FlxBox& box) {
+    unsigned int id;
+
+    if(!freeItems.empty()) {
+        id = freeItems.back();
+        freeItems.pop_back();
+    }
+    else {
+        id = items.size();
+        items.push_back(Item());
+    }
+
+    items[id].box = box;
+    link(id, findNode(box));
+    itemsCount++;
+
+    return id;
+}
+
+
+void FlxQuadTree::remove(unsigned int id) {
+    if(id >= items.size() || items[id].node < 0) return;
+
+    unlink(id);
+    freeItems.push_back(id);
+    itemsCount--;
+}
+
+
+void FlxQuadTree::move(unsigned int id, const FlxBox& box) {
+    if(id >= items.size() || items[id].node < 0) return;
+
+    items[id].box = box;
+
+    // still the right node? (the same rules as in findNode())
+    const Node& node = nodes[items[id].node];
+    float centerX = (box.minX + box.maxX) * 0.5f;
+    float centerY = (box.minY + box.maxY) * 0.5f;
+    float extent = std::max(box.maxX - box.minX, box.maxY - box.minY);
+
+    bool inside = centerX >= node.minX && centerX <= node.minX + node.size &&
+                  centerY >= node.minY && centerY <= node.minY + node.size;
+
+    if(inside && extent <= node.size && (node.depth == depthLimit || extent > node.size * 0.5f)) return;
+
+    int target = findNode(box);
+
+    if(target != items[id].node) {
+        unlink(id);
+        link(id, target);
+    }
+}
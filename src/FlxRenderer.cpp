@@ -0,0 +1,326 @@
+#include "FlxRenderer.h"
+#include "FlxG.h"
+#include <chrono>
+
+FlxRenderer::FlxRenderer() {
+    recordList = 0;
+    pipelined = requested = false;
+    lastCommandsCount = 0;
+    lastWaitTime = 0;
+
+    #ifndef FLX_NO_THREADS
+    thread = NULL;
+    submitted = stopping = false;
+    #endif
+}
+
+
+FlxRenderer::~FlxRenderer() {
+    shutdown();
+}
+
+
+void FlxRenderer::setPipelined(bool enabled) {
+    requested = enabled;
+}
+
+
+bool FlxRenderer::isPipelined() {
+    return pipelined;
+}
+
+
+bool FlxRenderer::hasRenderThread() {
+    #ifndef FLX_NO_THREADS
+    return thread != NULL;
+    #else
+    return false;
+    #endif
+}
+
+
+void FlxRenderer::start() {
+    pipelined = true;
+    recordList = 0;
+    lists[0].clear();
+    lists[1].clear();
+    sprites[0].clear();
+    sprites[1].clear();
+
+    #ifndef FLX_NO_THREADS
+    if(FlxG::backend && FlxG::backend->isRenderThreadSupported()) {
+        submitted = stopping = false;
+        thread = new std::thread(&FlxRenderer::renderLoop, this);
+    }
+    #endif
+}
+
+
+void FlxRenderer::shutdown() {
+    requested = false;
+    if(!pipelined) return;
+
+    #ifndef FLX_NO_THREADS
+    if(thread) {
+        flush();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        signal.notify_all();
+        thread->join();
+
+        delete thread;
+        thread = NULL;
+    }
+    #endif
+
+    pipelined = false;
+    collectGarbage();
+}
+
+
+void FlxRenderer::beginFrame() {
+
+    // switch mode between frames only
+    if(requested != pipelined) {
+        if(requested) start();
+        else shutdown();
+    }
+
+    if(!pipelined) {
+        FlxG::backend->beginDraw();
+    }
+}
+
+
+void FlxRenderer::endFrame() {
+    if(!pipelined) {
+        FlxG::backend->endDraw();
+        return;
+    }
+
+    lastCommandsCount = lists[recordList].size();
+
+    #ifndef FLX_NO_THREADS
+    if(thread) {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while(submitted) signal.wait(lock);
+
+            lastWaitTime = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start).count();
+
+            // previous frame is rendered, so texts destroyed since then aren't used anymore
+            collectGarbage();
+
+            submitted = true;
+            recordList ^= 1;
+        }
+
+        signal.notify_all();
+        lists[recordList].clear();
+        sprites[recordList].clear();
+        return;
+    }
+    #endif
+
+    // render thread not available, submit on main thread
+    FlxG::backend->beginDraw();
+    replay(recordList);
+    FlxG::backend->endDraw();
+
+    lists[recordList].clear();
+    sprites[recordList].clear();
+    collectGarbage();
+}
+
+
+void FlxRenderer::flush() {
+    #ifndef FLX_NO_THREADS
+    if(thread) {
+        std::unique_lock<std::mutex> lock(mutex);
+        while(submitted) signal.wait(lock);
+    }
+    #endif
+}
+
+
+void FlxRenderer::drawImage(FlxBackendImage *img, float x, float y, const FlxVector& scale, float angle,
+                            const FlxRect& source, int color, bool flipped, float alpha)
+{
+    if(!pipelined) {
+        FlxG::backend->drawImage(img, x, y, scale, angle, source, color, flipped, alpha);
+        return;
+    }
+
+    FlxDrawCommand command;
+    command.type = FlxDrawCommand::IMAGE;
+    command.data = img;
+    command.x = x;
+    command.y = y;
+    command.angle = angle;
+    command.scale = scale;
+    command.source = source;
+    command.color = color;
+    command.alpha = alpha;
+    command.flipped = flipped;
+    command.first = command.count = 0;
+
+    lists[recordList].push_back(command);
+}
+
+
+void FlxRenderer::drawImages(FlxBackendImage *img, const FlxBatchSprite *batch, unsigned int count,
+                             const FlxVector& scale, int color, float alpha)
+{
+    if(!pipelined) {
+        FlxG::backend->drawImages(img, batch, count, scale, color, alpha);
+        return;
+    }
+
+    if(count == 0) return;
+
+    // caller's buffer may change before the list is submitted
+    std::vector<FlxBatchSprite>& buffer = sprites[recordList];
+
+    FlxDrawCommand command;
+    command.type = FlxDrawCommand::IMAGES;
+    command.data = img;
+    command.x = command.y = command.angle = 0;
+    command.scale = scale;
+    command.color = color;
+    command.alpha = alpha;
+    command.flipped = false;
+    command.first = buffer.size();
+    command.count = count;
+
+    buffer.insert(buffer.end(), batch, batch + count);
+    lists[recordList].push_back(command);
+}
+
+
+void FlxRenderer::drawText(FlxBaseText *text, float x, float y, const FlxVector& scale, float angle) {
+    if(!pipelined) {
+        FlxG::backend->drawText(text, x, y, scale, angle);
+        return;
+    }
+
+    FlxDrawCommand command;
+    command.type = FlxDrawCommand::TEXT;
+    command.data = text;
+    command.x = x;
+    command.y = y;
+    command.angle = angle;
+    command.scale = scale;
+    command.color = 0;
+    command.alpha = 1.f;
+    command.flipped = false;
+    command.first = command.count = 0;
+
+    lists[recordList].push_back(command);
+}
+
+
+void FlxRenderer::drawShader(FlxBackendShader *shader) {
+    if(!pipelined) {
+        FlxG::backend->drawShader(shader);
+        return;
+    }
+
+    FlxDrawCommand command;
+    command.type = FlxDrawCommand::SHADER;
+    command.data = shader;
+    command.x = command.y = command.angle = 0;
+    command.color = 0;
+    command.alpha = 1.f;
+    command.flipped = false;
+    command.first = command.count = 0;
+
+    lists[recordList].push_back(command);
+}
+
+
+void FlxRenderer::destroyText(FlxBaseText *text) {
+    if(!pipelined) {
+        FlxG::backend->destroyText(text);
+        return;
+    }
+
+    if(text) garbage.push_back(text);
+}
+
+
+void FlxRenderer::replay(unsigned int index) {
+    FLX_PROFILE_ZONE("FlxRenderer::replay");
+
+    std::vector<FlxDrawCommand>& list = lists[index];
+
+    for(unsigned int i = 0; i < list.size(); i++) {
+        FlxDrawCommand& command = list[i];
+
+        switch(command.type) {
+            case FlxDrawCommand::IMAGE:
+                FlxG::backend->drawImage((FlxBackendImage*)command.data, command.x, command.y, command.scale,
+                                         command.angle, command.source, command.color, command.flipped,
+                                         command.alpha);
+                break;
+
+            case FlxDrawCommand::IMAGES:
+                FlxG::backend->drawImages((FlxBackendImage*)command.data, &sprites[index][command.first],
+                                          command.count, command.scale, command.color, command.alpha);
+                break;
+
+            case FlxDrawCommand::TEXT:
+                FlxG::backend->drawText((FlxBaseText*)command.data, command.x, command.y, command.scale,
+                                        command.angle);
+                break;
+
+            case FlxDrawCommand::SHADER:
+                FlxG::backend->drawShader((FlxBackendShader*)command.data);
+                break;
+        }
+    }
+}
+
+
+void FlxRenderer::collectGarbage() {
+    for(unsigned int i = 0; i < garbage.size(); i++) {
+        FlxG::backend->destroyText(garbage[i]);
+    }
+
+    garbage.clear();
+}
+
+
+#ifndef FLX_NO_THREADS
+void FlxRenderer::renderLoop() {
+    if(FlxProfiler::enabled) FlxProfiler::setThreadName("Render");
+
+    for(;;) {
+        unsigned int list;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while(!submitted && !stopping) signal.wait(lock);
+
+            if(!submitted) break;
+            list = recordList ^ 1;
+        }
+
+        FlxG::backend->beginDraw();
+        replay(list);
+        FlxG::backend->endDraw();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            submitted = false;
+        }
+
+        signal.notify_all();
+    }
+}
+#endif
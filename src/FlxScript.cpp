@@ -23,14 +23,43 @@ extern void FlxScriptMessageCallback(const asSMessageInfo *msg, void *param) {
 
 
 
+// declarations of functions called on FlxScriptEvent events
+static const char *FlxScriptEventDecls[FLX_SCRIPT_EVENTS_COUNT] = {
+    "void onApplicationInit()",
+    "void onApplicationExit()",
+    "void onStageBegin()",
+    "void onStageEnd()",
+    "void onFrameEnter()",
+    "void onRender()",
+    "void onObjectsContact(FlxObject@, FlxObject@)"
+};
+
+
 /*
    Script members
 */
+FlxScript::FlxScript(FlxScriptEngine *eng) {
+    engine = eng;
+    mainModule = NULL;
+
+    for(int i = 0; i < FLX_SCRIPT_EVENTS_COUNT; i++) {
+        hooks[i] = NULL;
+    }
+}
+
+
+void FlxScript::resolveHooks() {
+    for(int i = 0; i < FLX_SCRIPT_EVENTS_COUNT; i++) {
+        hooks[i] = mainModule ? mainModule->GetFunctionByDecl(FlxScriptEventDecls[i]) : NULL;
+    }
+}
+
+
 asIScriptContext *FlxScript::findFunction(const char *funcDecl) {
     asIScriptFunction *func = mainModule->GetFunctionByDecl(funcDecl);
     if(func == 0) return NULL;
 
-    asIScriptContext *ctx = engine->getCore()->CreateContext();
+    asIScriptContext *ctx = engine->requestContext();
     ctx->Prepare(func);
 
     return ctx;
@@ -38,7 +67,29 @@ asIScriptContext *FlxScript::findFunction(const char *funcDecl) {
 
 
 void FlxScript::endCall(asIScriptContext *ctx) {
-    if(ctx) ctx->Release();
+    if(ctx) engine->returnContext(ctx);
+}
+
+
+void FlxScript::callEvent(FlxScriptEvent event) {
+    asIScriptFunction *func = hooks[event];
+    if(!func) return;
+
+    asIScriptContext *ctx = engine->requestContext();
+    ctx->Prepare(func);
+    ctx->Execute();
+    engine->returnContext(ctx);
+}
+
+
+asIScriptContext *FlxScript::prepareEvent(FlxScriptEvent event) {
+    asIScriptFunction *func = hooks[event];
+    if(!func) return NULL;
+
+    asIScriptContext *ctx = engine->requestContext();
+    ctx->Prepare(func);
+
+    return ctx;
 }
 
 
@@ -63,10 +114,34 @@ void FlxScriptEngine::init() {
 
 
 void FlxScriptEngine::finalize() {
+    for(unsigned int i = 0; i < contexts.size(); i++) {
+        contexts[i]->Release();
+    }
+
+    contexts.clear();
     engine->Release();
 }
 
 
+asIScriptContext* FlxScriptEngine::requestContext() {
+    if(contexts.empty()) return engine->CreateContext();
+
+    // reuse context (nested calls take next free one)
+    asIScriptContext *ctx = contexts.back();
+    contexts.pop_back();
+
+    return ctx;
+}
+
+
+void FlxScriptEngine::returnContext(asIScriptContext *ctx) {
+    if(!ctx) return;
+
+    ctx->Unprepare();
+    contexts.push_back(ctx);
+}
+
+
 FlxScript* FlxScriptEngine::loadScript(const char *path) {
 
     // read script from file
@@ -92,6 +167,7 @@ FlxScript* FlxScriptEngine::loadScript(const char *path) {
     if(script->builder.BuildModule() < 0) { delete script; return NULL; }
 
     script->mainModule = engine->GetModule(path);
+    script->resolveHooks();
 
 	delete[] buffer;
     return script;
@@ -400,7 +476,7 @@ static unsigned int getEntitiesCount() {
 static bool isObject(unsigned int idx) {
     if(FlxG::state) {
         if(idx >= FlxG::state->members.size()) return false;
-        return FlxG::state->members[idx]->entityType == FLX_OBJECT;
+        return FlxG::state->members[idx] && FlxG::state->members[idx]->entityType == FLX_OBJECT;
     }
 
     return false;
@@ -410,7 +486,7 @@ static bool isObject(unsigned int idx) {
 static bool isGroup(unsigned int idx) {
     if(FlxG::state) {
         if(idx >= FlxG::state->members.size()) return false;
-        return FlxG::state->members[idx]->entityType == FLX_GROUP;
+        return FlxG::state->members[idx] && FlxG::state->members[idx]->entityType == FLX_GROUP;
     }
 
     return false;
@@ -418,7 +494,7 @@ static bool isGroup(unsigned int idx) {
 
 
 static FlxObject* getObject(unsigned int idx) {
-    if(FlxG::state) {
+    if(isObject(idx)) {
         return (FlxObject*) FlxG::state->members[idx];
     }
 
@@ -427,7 +503,7 @@ static FlxObject* getObject(unsigned int idx) {
 
 
 static FlxGroup* getGroup(unsigned int idx) {
-    if(FlxG::state) {
+    if(isGroup(idx)) {
         return (FlxGroup*) FlxG::state->members[idx];
     }
 
@@ -435,6 +511,21 @@ static FlxGroup* getGroup(unsigned int idx) {
 }
 
 
+static FlxObject* getObjectByHandle(FlxHandle handle) {
+    return FlxHandles::getObject(handle);
+}
+
+
+static FlxGroup* getGroupByHandle(FlxHandle handle) {
+    return FlxHandles::getGroup(handle);
+}
+
+
+static bool isHandleValid(FlxHandle handle) {
+    return FlxHandles::isValid(handle);
+}
+
+
 static FlxBasic* addObject(FlxObject *obj) {
     if(FlxG::state) {
         return FlxG::state->add(obj);
@@ -456,7 +547,7 @@ static FlxBasic* addGroup(FlxGroup *group) {
 static bool isObjectByFlag(int flag) {
     if(FlxG::state) {
         for(unsigned int i = 0; i < FlxG::state->members.size(); i++) {
-            if(FlxG::state->members[i]->flags == flag) {
+            if(FlxG::state->members[i] && FlxG::state->members[i]->flags == flag) {
                 return FlxG::state->members[i]->entityType == FLX_OBJECT;
             }
         }
@@ -469,7 +560,7 @@ static bool isObjectByFlag(int flag) {
 static bool isGroupByFlag(int flag) {
     if(FlxG::state) {
         for(unsigned int i = 0; i < FlxG::state->members.size(); i++) {
-            if(FlxG::state->members[i]->flags == flag) {
+            if(FlxG::state->members[i] && FlxG::state->members[i]->flags == flag) {
                 return FlxG::state->members[i]->entityType == FLX_GROUP;
             }
         }
@@ -482,7 +573,7 @@ static bool isGroupByFlag(int flag) {
 static FlxObject* getObjectByFlag(int flag) {
     if(FlxG::state) {
         for(unsigned int i = 0; i < FlxG::state->members.size(); i++) {
-            if(FlxG::state->members[i]->flags == flag) {
+            if(FlxG::state->members[i] && FlxG::state->members[i]->flags == flag) {
                 return (FlxObject*) FlxG::state->members[i];
             }
         }
@@ -495,7 +586,7 @@ static FlxObject* getObjectByFlag(int flag) {
 static FlxGroup* getGroupByFlag(int flag) {
     if(FlxG::state) {
         for(unsigned int i = 0; i < FlxG::state->members.size(); i++) {
-            if(FlxG::state->members[i]->flags == flag) {
+            if(FlxG::state->members[i] && FlxG::state->members[i]->flags == flag) {
                 return (FlxGroup*) FlxG::state->members[i];
             }
         }
@@ -562,16 +653,16 @@ static void scriptCollisionCallback(FlxBasic *obj1, FlxBasic *obj2) {
 
     // call onObjectsContact() in every global utility script
     for(unsigned int i = 0; i < FlxG::globalScripts.members.size(); i++) {
-    FLX_CONTEXT *ctx = NULL;
-    if((ctx = FlxG::globalScripts.members[i]->findFunction("void onObjectsContact(FlxObject@, \
-                                                            FlxObject@)")) != NULL)
-        {
-            ctx->SetArgObject(0, (FlxObject*) obj1);
-            ctx->SetArgObject(1, (FlxObject*) obj2);
-
-            ctx->Execute();
-            ctx->Release();
-        }
+        FlxScript *script = FlxG::globalScripts.members[i];
+
+        FLX_CONTEXT *ctx = script->prepareEvent(FLX_SCRIPT_OBJECTS_CONTACT);
+        if(!ctx) continue;
+
+        ctx->SetArgObject(0, (FlxObject*) obj1);
+        ctx->SetArgObject(1, (FlxObject*) obj2);
+
+        ctx->Execute();
+        script->endCall(ctx);
     }
 }
 
@@ -762,6 +853,7 @@ void FlxScriptEngine::bindFlixelFunctionality() {
     registerClassProperty("FlxObject", "FlxVector maxVelocity", asOFFSET(FlxObject, maxVelocity));
     registerClassProperty("FlxObject", "float angularVelocity", asOFFSET(FlxObject, angularVelocity));
     registerClassProperty("FlxObject", "float angle", asOFFSET(FlxObject, angle));
+    registerClassProperty("FlxObject", "float z", asOFFSET(FlxObject, z));
     registerClassProperty("FlxObject", "float scale", asOFFSET(FlxObject, scale));
     registerClassProperty("FlxObject", "int color", asOFFSET(FlxObject, color));
     registerClassProperty("FlxObject", "FlxRect hitbox", asOFFSET(FlxObject, hitbox));
@@ -772,8 +864,11 @@ void FlxScriptEngine::bindFlixelFunctionality() {
     registerClassProperty("FlxObject", "bool isFollowingPath", asOFFSET(FlxObject, isFollowingPath));
     registerClassProperty("FlxObject", "float followingVelocity", asOFFSET(FlxObject, followingVelocity));
     registerClassProperty("FlxObject", "int flags", asOFFSET(FlxObject, flags));
+    registerClassProperty("FlxObject", "const uint handle", asOFFSET(FlxObject, handle));
     registerMethod("FlxObject", "FlxVector@ getCenter()", asMETHOD(FlxObject, getCenter));
     registerMethod("FlxObject", "void kill()", asMETHOD(FlxObject, kill));
+    registerMethod("FlxObject", "void revive()", asMETHOD(FlxObject, revive));
+    registerClassProperty("FlxObject", "bool alive", asOFFSET(FlxObject, alive));
 
     registerType("FlxGroup", sizeof(FlxGroup), asOBJ_REF);
     registerClassAddref("FlxGroup", "void f()", asFUNCTION(FlxObject_addRef), asCALL_GENERIC);
@@ -790,6 +885,7 @@ void FlxScriptEngine::bindFlixelFunctionality() {
     registerMethod("FlxGroup", "FlxGroup@ getGroup(int idx)", asMETHOD(FlxGroup, _getGroup));
     registerMethod("FlxGroup", "void clear()", asMETHOD(FlxGroup, clear));
     registerClassProperty("FlxGroup", "int flags", asOFFSET(FlxGroup, flags));
+    registerClassProperty("FlxGroup", "const uint handle", asOFFSET(FlxGroup, handle));
     registerClassFactory("FlxGroup", "FlxGroup@ f()", asFUNCTION(FlxGroup_create), asCALL_GENERIC);
 
     registerFunction("uint getEntitiesCount()", asFUNCTION(getEntitiesCount));
@@ -802,6 +898,11 @@ void FlxScriptEngine::bindFlixelFunctionality() {
     registerFunction("FlxObject@ getObjectByFlag(int flag)", asFUNCTION(getObjectByFlag));
     registerFunction("FlxGroup@ getGroupByFlag(int flag)", asFUNCTION(getGroupByFlag));
 
+    // handles (keep them instead of FlxObject@/FlxGroup@ when entity may be removed meanwhile)
+    registerFunction("FlxObject@ getObjectByHandle(uint handle)", asFUNCTION(getObjectByHandle));
+    registerFunction("FlxGroup@ getGroupByHandle(uint handle)", asFUNCTION(getGroupByHandle));
+    registerFunction("bool isHandleValid(uint handle)", asFUNCTION(isHandleValid));
+
     registerFunction("FlxObject@ addEntity(FlxObject@ obj)", asFUNCTION(addObject));
     registerFunction("FlxGroup@ addEntity(FlxGroup@ obj)", asFUNCTION(addGroup));
 
@@ -1,39 +1,295 @@
 #include "FlxSound.h"
 #include "FlxG.h"
 
-std::vector<FlxBackendSound*> FlxSound::Sounds;
+// handle = voice index (low 16 bits) + voice generation (high 16 bits)
+#define FLX_VOICE_INDEX(handle) ((handle) & 0xFFFF)
+#define FLX_VOICE_GENERATION(handle) ((handle) >> 16)
+#define FLX_VOICE_INACTIVE 0xFFFFFFFF
 
-FlxSound::FlxSound(const char *path) {
+FlxVoicePool FlxSound::Voices;
+
+/*
+   Voices pool members
+*/
+FlxVoicePool::FlxVoicePool() {
+    capacity = 32;
+    maxInstances = 8;
+    playCounter = 0;
+    stolenVoices = rejectedSounds = 0;
+}
+
+
+void FlxVoicePool::setCapacity(unsigned int count) {
+    if(count > 0xFFFF) count = 0xFFFF;
+    capacity = count;
+
+    // destroy voices above new limit (they are always at the end)
+    while(voices.size() > capacity) {
+        unsigned int index = voices.size() - 1;
+
+        if(voices[index].activeIndex != FLX_VOICE_INACTIVE) release(index);
+
+        for(unsigned int i = 0; i < freeVoices.size(); i++) {
+            if(freeVoices[i] == index) {
+                freeVoices[i] = freeVoices.back();
+                freeVoices.pop_back();
+                break;
+            }
+        }
+
+        delete voices[index].sound;
+        voices.pop_back();
+    }
+}
+
+
+unsigned int FlxVoicePool::getCapacity() {
+    return capacity;
+}
+
+
+unsigned int FlxVoicePool::getActiveCount() {
+    return active.size();
+}
+
+
+void FlxVoicePool::setMaxInstances(void *sound, unsigned int count) {
+    if(sound) limits[sound] = count;
+}
+
+
+int FlxVoicePool::acquire(void *buffer, int priority) {
+
+    // too many instances of this sound? restart the oldest one
+    std::map<void*, unsigned int>::iterator limit = limits.find(buffer);
+    unsigned int maxCount = (limit != limits.end()) ? limit->second : maxInstances;
+
+    if(maxCount > 0 && instances[buffer] >= maxCount) {
+        int oldest = -1;
+
+        for(unsigned int i = 0; i < active.size(); i++) {
+            Voice& voice = voices[active[i]];
+
+            if(voice.buffer == buffer && (oldest < 0 || voice.order < voices[oldest].order)) {
+                oldest = active[i];
+            }
+        }
+
+        if(oldest >= 0) {
+            release(oldest);
+            stolenVoices++;
+        }
+    }
+
+    // free voice
+    if(!freeVoices.empty()) {
+        unsigned int index = freeVoices.back();
+        freeVoices.pop_back();
+        return index;
+    }
+
+    // create new voice
+    if(voices.size() < capacity) {
+        Voice voice;
+        voice.sound = FlxG::backend->createSound();
+        if(!voice.sound) return -1;
+
+        voice.buffer = NULL;
+        voice.priority = 0;
+        voice.generation = 1;
+        voice.activeIndex = FLX_VOICE_INACTIVE;
+        voice.order = 0;
+
+        voices.push_back(voice);
+        return voices.size() - 1;
+    }
+
+    // steal voice with the lowest priority (the oldest one on tie)
+    int victim = -1;
+
+    for(unsigned int i = 0; i < active.size(); i++) {
+        Voice& voice = voices[active[i]];
+        if(voice.priority > priority) continue;
+
+        if(victim < 0 || voice.priority < voices[victim].priority ||
+           (voice.priority == voices[victim].priority && voice.order < voices[victim].order))
+        {
+            victim = active[i];
+        }
+    }
+
+    if(victim < 0) {
+        rejectedSounds++;
+        return -1;
+    }
+
+    release(victim);
+    stolenVoices++;
+
+    freeVoices.pop_back();
+    return victim;
+}
+
+
+void FlxVoicePool::release(unsigned int index) {
+    Voice& voice = voices[index];
+    if(voice.activeIndex == FLX_VOICE_INACTIVE) return;
+
+    voice.sound->stop();
+
+    std::map<void*, unsigned int>::iterator it = instances.find(voice.buffer);
+    if(it != instances.end() && it->second > 0) it->second--;
+
+    // O(1) swap-remove from active voices
+    unsigned int last = active.back();
+    active[voice.activeIndex] = last;
+    voices[last].activeIndex = voice.activeIndex;
+    active.pop_back();
+
+    voice.activeIndex = FLX_VOICE_INACTIVE;
+
+    // invalidate old handles
+    voice.generation = (voice.generation + 1) & 0xFFFF;
+    if(voice.generation == 0) voice.generation = 1;
+
+    freeVoices.push_back(index);
+}
+
+
+FlxVoicePool::Voice* FlxVoicePool::getVoice(FlxVoiceHandle handle) {
+    unsigned int index = FLX_VOICE_INDEX(handle);
+
+    if(handle == 0 || index >= voices.size()) return NULL;
+    if(voices[index].generation != FLX_VOICE_GENERATION(handle)) return NULL;
+    if(voices[index].activeIndex == FLX_VOICE_INACTIVE) return NULL;
+
+    return &voices[index];
+}
+
+
+FlxVoiceHandle FlxVoicePool::play(void *sound, float vol, int priority, bool looped) {
+    if(!sound || !FlxG::backend) return 0;
+
+    int index = acquire(sound, priority);
+    if(index < 0) return 0;
+
+    Voice& voice = voices[index];
+    voice.buffer = sound;
+    voice.priority = priority;
+    voice.order = playCounter++;
+    voice.activeIndex = active.size();
+    active.push_back(index);
+    instances[sound]++;
+
+    voice.sound->setSound(sound);
+    voice.sound->setLoop(looped);
+    voice.sound->setVolume(vol);
+    voice.sound->play();
+
+    return (voice.generation << 16) | index;
+}
+
+
+void FlxVoicePool::stop(FlxVoiceHandle handle) {
+    if(getVoice(handle)) release(FLX_VOICE_INDEX(handle));
+}
+
+
+bool FlxVoicePool::isPlaying(FlxVoiceHandle handle) {
+    Voice *voice = getVoice(handle);
+    return voice && voice->sound->isPlaying();
+}
+
+
+void FlxVoicePool::setVolume(FlxVoiceHandle handle, float vol) {
+    Voice *voice = getVoice(handle);
+    if(voice) voice->sound->setVolume(vol);
+}
+
+
+void FlxVoicePool::setLooped(FlxVoiceHandle handle, bool loop) {
+    Voice *voice = getVoice(handle);
+    if(voice) voice->sound->setLoop(loop);
+}
+
+
+void FlxVoicePool::update() {
+    for(unsigned int i = 0; i < active.size(); ) {
+
+        // release() moves last active voice into current slot
+        if(!voices[active[i]].sound->isPlaying()) {
+            release(active[i]);
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+
+void FlxVoicePool::stopAll() {
+    while(!active.empty()) {
+        release(active.back());
+    }
+}
+
+
+void FlxVoicePool::clear() {
+    stopAll();
+
+    for(unsigned int i = 0; i < voices.size(); i++) {
+        delete voices[i].sound;
+    }
+
+    voices.clear();
+    freeVoices.clear();
+    instances.clear();
+    limits.clear();
+}
+
+
+/*
+   Sound members
+*/
+FlxSound::FlxSound(const char *path, int Priority) {
     soundBufferPtr = FlxG::backend->loadSound(path);
-    soundPtr = NULL;
+    voice = 0;
+    looped = false;
+    priority = Priority;
 }
 
 
 void FlxSound::play(float vol) {
-    if(soundPtr) stop();
+    if(voice) stop();
 
-    soundPtr = FlxG::backend->playSound(soundBufferPtr, vol);
-    Sounds.push_back(soundPtr);
+    voice = Voices.play(soundBufferPtr, vol, priority, looped);
 }
 
 
 void FlxSound::stop() {
-    if(!soundPtr) return;
+    if(!voice) return;
 
-    soundPtr->stop();
-    soundPtr = NULL;
+    Voices.stop(voice);
+    voice = 0;
 }
 
 
 bool FlxSound::isPlaying() {
-    if(!soundPtr) return false;
-
-    return soundPtr->isPlaying();
+    return Voices.isPlaying(voice);
 }
 
 
 void FlxSound::setLooped(bool loop) {
-    if(!soundPtr) return;
+    looped = loop;
+    Voices.setLooped(voice, loop);
+}
+
+
+void FlxSound::setVolume(float vol) {
+    Voices.setVolume(voice, vol);
+}
+
 
-    soundPtr->setLoop(loop);
+void FlxSound::setMaxInstances(unsigned int count) {
+    Voices.setMaxInstances(soundBufferPtr, count);
 }
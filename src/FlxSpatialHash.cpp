@@ -0,0 +1,129 @@
+#include "FlxSpatialHash.h"
+
+// cell coordinates are clamped, so far away boxes don't overflow hash (they share border cells)
+static const float MaxCell = (float)(1 << 24);
+
+
+FlxSpatialHash::FlxSpatialHash() {
+    cellSize = invCellSize = 1.f;
+    bucketMask = 0;
+    built = false;
+}
+
+
+void FlxSpatialHash::clear() {
+    items.clear();
+    entries.clear();
+    largeItems.clear();
+    built = false;
+}
+
+
+int FlxSpatialHash::getCell(float coord) const {
+    float cell = std::floor(coord * invCellSize);
+
+    if(cell < -MaxCell) return -(int)MaxCell;
+    if(cell > MaxCell) return (int)MaxCell;
+
+    // NaN
+    if(cell != cell) return 0;
+
+    return (int) cell;
+}
+
+
+void FlxSpatialHash::getCells(const Box& box, int& x0, int& y0, int& x1, int& y1) const {
+    x0 = getCell(box.minX);
+    y0 = getCell(box.minY);
+    x1 = getCell(box.maxX);
+    y1 = getCell(box.maxY);
+
+    if(x1 < x0) x1 = x0;
+    if(y1 < y0) y1 = y0;
+}
+
+
+void FlxSpatialHash::begin(float size) {
+    clear();
+
+    cellSize = (size > 0) ? size : 1.f;
+    invCellSize = 1.f / cellSize;
+}
+
+
+unsigned int FlxSpatialHash::insert(const Box& box) {
+    Item item;
+    item.box = box;
+    getCells(box, item.cellX0, item.cellY0, item.cellX1, item.cellY1);
+
+    items.push_back(item);
+    return items.size() - 1;
+}
+
+
+void FlxSpatialHash::end() {
+    unsigned int cellsCount = 0;
+
+    for(unsigned int i = 0; i < items.size(); i++) {
+        const Item& item = items[i];
+        long long cells = (long long)(item.cellX1 - item.cellX0 + 1) * (item.cellY1 - item.cellY0 + 1);
+
+        if(cells > MaxCellsPerBox) largeItems.push_back(i);
+        else cellsCount += (unsigned int) cells;
+    }
+
+    // about two buckets per entry keeps chains short
+    unsigned int buckets = 16;
+    while(buckets < cellsCount * 2) buckets <<= 1;
+
+    bucketMask = buckets - 1;
+    bucketStarts.assign(buckets + 1, 0);
+    entries.resize(cellsCount);
+
+    unsigned int large = 0;
+
+    // count entries of every bucket...
+    for(unsigned int i = 0; i < items.size(); i++) {
+        if(large < largeItems.size() && largeItems[large] == i) {
+            large++;
+            continue;
+        }
+
+        const Item& item = items[i];
+
+        for(int y = item.cellY0; y <= item.cellY1; y++) {
+            for(int x = item.cellX0; x <= item.cellX1; x++) {
+                bucketStarts[(hashCell(x, y) & bucketMask) + 1]++;
+            }
+        }
+    }
+
+    for(unsigned int b = 0; b < buckets; b++) {
+        bucketStarts[b + 1] += bucketStarts[b];
+    }
+
+    // ...and fill them in order of boxes (every start is moved to the start of the next bucket meanwhile)
+    large = 0;
+
+    for(unsigned int i = 0; i < items.size(); i++) {
+        if(large < largeItems.size() && largeItems[large] == i) {
+            large++;
+            continue;
+        }
+
+        const Item& item = items[i];
+
+        for(int y = item.cellY0; y <= item.cellY1; y++) {
+            for(int x = item.cellX0; x <= item.cellX1; x++) {
+                entries[bucketStarts[hashCell(x, y) & bucketMask]++] = i;
+            }
+        }
+    }
+
+    for(unsigned int b = buckets; b > 0; b--) {
+        bucketStarts[b] = bucketStarts[b - 1];
+    }
+
+    bucketStarts[0] = 0;
+    built = true;
+}
@@ -65,9 +65,17 @@ void FlxSprite::draw() {
     move.y *= scroolFactor.y;
     if(!scrool) { move.x = move.y = 0; }
 
-    FlxG::backend->drawImage(graphic, x + move.x, y + move.y, scale, angle,
-                            FlxRect(sourceX, sourceY, width, height), color,
-                            flipped, alpha);
+    FlxVector pos = getDrawPosition();
+
+    FLX_PROFILE_ZONE("Backend::drawImage");
+    FlxG::renderer.drawImage(graphic, pos.x + move.x, pos.y + move.y, scale, getDrawAngle(),
+                             FlxRect(sourceX, sourceY, width, height), color,
+                             flipped, alpha);
+}
+
+
+const void* FlxSprite::getTextureKey() {
+    return graphic;
 }
 
 
@@ -19,7 +19,7 @@ FlxText::FlxText(const wchar_t *Text, const char *Font, float X, float Y, int Si
 
 
 FlxText::~FlxText() {
-    FlxG::backend->destroyText(textData);
+    FlxG::renderer.destroyText(textData);
 }
 
 
@@ -65,13 +65,16 @@ void FlxText::draw() {
     move.y *= scroolFactor.y;
     if(!scrool) { move.x = move.y = 0; }
 
-    FlxG::backend->drawText(textData, x + move.x, y + move.y, scale, angle);
+    FlxVector pos = getDrawPosition();
+
+    FLX_PROFILE_ZONE("Backend::drawText");
+    FlxG::renderer.drawText(textData, pos.x + move.x, pos.y + move.y, scale, getDrawAngle());
 }
 
 
 void FlxText::updateBuffer() {
 
-    FlxG::backend->destroyText(textData);
+    FlxG::renderer.destroyText(textData);
     textData = FlxG::backend->createText(text.c_str(), font, size, color, alpha);
 
     if(textData) {
@@ -1,5 +1,6 @@
 #include "FlxTilemap.h"
 #include "FlxG.h"
+#include <algorithm>
 
 #ifndef FLX_NO_PATHFINDING
     #include "astar/stlastar.h"
@@ -17,12 +18,16 @@ extern void FlxDefaultTileCallback(FlxTilemap *map, FlxTile *tile) {
 // FlxTilemap members start here
 FlxTilemap::FlxTilemap(const InsertionCallback& callback) {
     mapData = NULL;
+    firstSolid = 1;
+    tileWidth = tileHeight = 0;
 
     if(callback == nullptr) {
         insertionCallback = FlxDefaultTileCallback;
+        defaultInsertion = true;
     }
     else {
         insertionCallback = callback;
+        defaultInsertion = false;
     }
 }
 
@@ -43,6 +48,8 @@ void FlxTilemap::loadMap(int *map, int sizeX, int sizeY, const char *tileset, in
     bounds.width = static_cast<int>(sizeInPixels.x);
     bounds.height = static_cast<int>(sizeInPixels.y);
     firstSolid = firstCollide;
+    this->tileWidth = tileWidth;
+    this->tileHeight = tileHeight;
 
     mapData = new int[sizeX * sizeY];
 
@@ -51,6 +58,8 @@ void FlxTilemap::loadMap(int *map, int sizeX, int sizeY, const char *tileset, in
         mapData[i] = map[i];
     }
 
+    cellTiles.assign(sizeX * sizeY, FLX_NO_HANDLE);
+
     // fill map data
     int x = 0, y = 0;
     for(int i = 0; i < sizeX * sizeY; i++) {
@@ -62,12 +71,13 @@ void FlxTilemap::loadMap(int *map, int sizeX, int sizeY, const char *tileset, in
             tile->addAnimation("__default", FlxInitializerList<unsigned int>(mapData[i]));
             tile->play("__default");
 
-            tile->collisions = (mapData[i] >= firstSolid);
+            tile->collisions = isTileSolid(mapData[i]);
             tile->indexX = x;
             tile->indexY = y;
             tile->type = mapData[i];
 
             insertionCallback(this, tile);
+            if(defaultInsertion) cellTiles[i] = tile->handle;
         }
 
         if(x == sizeX - 1) {
@@ -100,6 +110,14 @@ void FlxTilemap::setTile(int x, int y, int value) {
 
     if(x < 0 || y < 0 || x >= (int)size.x || y >= (int)size.y) return;
     mapData[(y * (int)size.x) + x] = value;
+
+    // tile member of the cell collides like its new type
+    FlxTile *tile = (FlxTile*) FlxHandles::getObject(cellTiles[(y * (int)size.x) + x]);
+
+    if(tile) {
+        tile->type = value;
+        tile->collisions = isTileSolid(value);
+    }
 }
 
 
@@ -108,10 +126,156 @@ void FlxTilemap::setTilesProperty(int index, int flags) {
     for(unsigned int i = 0; i < members.size(); i++) {
         FlxTile *tile = (FlxTile*) members[i];
 
-        if(tile->type == index) {
+        if(tile && tile->type == index) {
             tile->collisionsFlags = flags;
         }
     }
+
+    if(index >= 0) getTileType(index).collisionsFlags = flags;
+}
+
+
+FlxTilemap::TileType& FlxTilemap::getTileType(int index) {
+    while((int)tileTypes.size() <= index) {
+        TileType type = { (int)tileTypes.size() >= firstSolid, 0 };
+        tileTypes.push_back(type);
+    }
+
+    return tileTypes[index];
+}
+
+
+void FlxTilemap::setTileSolid(int index, bool solid) {
+
+    for(unsigned int i = 0; i < members.size(); i++) {
+        FlxTile *tile = (FlxTile*) members[i];
+
+        if(tile && tile->type == index) {
+            tile->collisions = solid;
+        }
+    }
+
+    if(index >= 0) getTileType(index).solid = solid;
+}
+
+
+bool FlxTilemap::isTileSolid(int index) {
+    if(index < 0) return false;
+    if(index < (int)tileTypes.size()) return tileTypes[index].solid;
+
+    return index >= firstSolid;
+}
+
+
+FlxTile* FlxTilemap::getCollisionTile(int x, int y, int type) {
+    FlxTile *tile = &collisionTile;
+
+    tile->x = tile->hitbox.x = static_cast<float>(x * tileWidth);
+    tile->y = tile->hitbox.y = static_cast<float>(y * tileHeight);
+    tile->width = tile->hitbox.width = tileWidth;
+    tile->height = tile->hitbox.height = tileHeight;
+    tile->indexX = x;
+    tile->indexY = y;
+    tile->type = type;
+    tile->collisions = isTileSolid(type);
+    tile->collisionsFlags = (type < (int)tileTypes.size()) ? tileTypes[type].collisionsFlags : 0;
+
+    // previous callback could kill or hide it
+    tile->alive = tile->active = tile->visible = true;
+
+    return tile;
+}
+
+
+FlxTile* FlxTilemap::getCellTile(int x, int y, int type) {
+    unsigned int cell = y * static_cast<int>(size.x) + x;
+    if(cellTiles[cell] == FLX_NO_HANDLE) return getCollisionTile(x, y, type);
+
+    // tile destroyed or removed from map, cell is empty since then
+    FlxBasic *tile = FlxHandles::resolve(cellTiles[cell]);
+
+    if(!tile || indexOf(tile) < 0) {
+        cellTiles[cell] = FLX_NO_HANDLE;
+        mapData[cell] = -1;
+        return NULL;
+    }
+
+    return (FlxTile*) tile;
+}
+
+
+bool FlxTilemap::checkObject(FlxObject *object, bool separate, const CollisionCallback& callback, FlxBasic *&hit) {
+    hit = NULL;
+
+    if(!mapData || !defaultInsertion || tileWidth <= 0 || tileHeight <= 0) return false;
+    if(!object->alive || (separate && !object->collisions)) return true;
+
+    // cells under hitbox (and its motion in one step)
+    const FlxRect& hitbox = object->hitbox;
+    float minX = hitbox.x, minY = hitbox.y;
+    float maxX = hitbox.x + hitbox.width, maxY = hitbox.y + hitbox.height;
+
+    if(separate) {
+        float dt = FlxG::fixedTime;
+        minX += std::min(object->velocity.x * dt, 0.f);
+        minY += std::min(object->velocity.y * dt, 0.f);
+        maxX += std::max(object->velocity.x * dt, 0.f);
+        maxY += std::max(object->velocity.y * dt, 0.f);
+    }
+
+    // outside of map (or NaN)
+    if(!(maxX >= 0 && maxY >= 0 && minX <= sizeInPixels.x && minY <= sizeInPixels.y)) return true;
+
+    int columns = static_cast<int>(size.x);
+    int rows = static_cast<int>(size.y);
+
+    int x0 = std::max(static_cast<int>(minX / tileWidth), 0);
+    int y0 = std::max(static_cast<int>(minY / tileHeight), 0);
+    int x1 = std::min(static_cast<int>(std::min(maxX, sizeInPixels.x) / tileWidth), columns - 1);
+    int y1 = std::min(static_cast<int>(std::min(maxY, sizeInPixels.y) / tileHeight), rows - 1);
+
+    FlxTile *hitTile = NULL;
+    int hitX = 0, hitY = 0, hitType = -1;
+    int cellsX = x1 - x0 + 1, cellsY = y1 - y0 + 1;
+
+    // the same order as loops over tile members (collide() walks them backwards)
+    for(int i = 0; i < cellsY; i++) {
+        int y = separate ? y1 - i : y0 + i;
+
+        for(int j = 0; j < cellsX; j++) {
+            int x = separate ? x1 - j : x0 + j;
+            int type = mapData[y * columns + x];
+            if(type < 0) continue;
+
+            FlxTile *tile = getCellTile(x, y, type);
+            if(!tile || !tile->alive) continue;
+
+            // only solid cells can stop objects
+            if(separate && !tile->collisions) continue;
+
+            bool touched;
+
+            if(separate) {
+                touched = object->collide(tile, callback) != NULL;
+            }
+            else {
+                touched = object->hitbox.overlaps(tile->hitbox);
+                if(touched && callback != nullptr) callback(object, tile);
+            }
+
+            if(touched) {
+                hitTile = (tile == &collisionTile) ? NULL : tile;
+                hitX = x;
+                hitY = y;
+                hitType = type;
+            }
+        }
+    }
+
+    if(hitTile) hit = hitTile;
+    else if(hitType >= 0) hit = getCollisionTile(hitX, hitY, hitType);
+
+    return true;
 }
 
 
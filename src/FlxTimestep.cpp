@@ -0,0 +1,77 @@
+#include "FlxTimestep.h"
+
+// accept tiny rounding errors of timers, so exact frame times doesn't produce 0/2 updates
+#define FLX_TIMESTEP_EPSILON 1e-6
+
+FlxTimestep::FlxTimestep() {
+    maxSubsteps = 10;
+    maxFrameTime = 0.25f;
+    policy = DROP_TIME;
+
+    reset();
+    resetStats();
+}
+
+
+unsigned int FlxTimestep::advance(float elapsed, float step) {
+    if(step <= 0) return 0;
+
+    if(elapsed < 0) elapsed = 0;
+
+    // very long frames (debugger, window dragging) are never simulated
+    if(maxFrameTime > 0 && elapsed > maxFrameTime) {
+        droppedTime += elapsed - maxFrameTime;
+        elapsed = maxFrameTime;
+    }
+
+    accumulator += elapsed;
+
+    unsigned int steps = (unsigned int)((accumulator + FLX_TIMESTEP_EPSILON) / step);
+
+    if(maxSubsteps > 0 && steps > maxSubsteps) {
+        unsigned int late = steps - maxSubsteps;
+        steps = maxSubsteps;
+        lateFrames++;
+
+        if(policy == DROP_TIME) {
+            droppedSteps += late;
+            droppedTime += late * (double)step;
+            accumulator -= late * (double)step;
+        }
+        else if(late > maxSubsteps) {
+            // carry at most one more full frame of updates
+            unsigned int dropped = late - maxSubsteps;
+
+            droppedSteps += dropped;
+            droppedTime += dropped * (double)step;
+            accumulator -= dropped * (double)step;
+        }
+    }
+
+    accumulator -= steps * (double)step;
+    if(accumulator < 0) accumulator = 0;
+
+    lastSubsteps = steps;
+    return steps;
+}
+
+
+float FlxTimestep::getAlpha(float step) {
+    if(step <= 0) return 0;
+
+    float alpha = (float)(accumulator / step);
+    return (alpha > 1.f) ? 1.f : alpha;
+}
+
+
+void FlxTimestep::reset() {
+    accumulator = 0;
+    lastSubsteps = 0;
+}
+
+
+void FlxTimestep::resetStats() {
+    droppedTime = 0;
+    droppedSteps = 0;
+    lateFrames = 0;
+}
@@ -89,6 +89,7 @@ void FlxVirtualKeyboard::pressedCallback(FlxButton *button) {
 
         for(unsigned int i = 1; i < members.size(); i++) {
             FlxButton *b = (FlxButton*)members[i];
+            if(!b) continue;
 
             if(b->onText->text != L"ENT" &&  b->onText->text != L"CAP" &&
                b->onText->text != L"_" && b->onText->text != L"BAC")
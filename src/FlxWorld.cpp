@@ -0,0 +1,543 @@
+#include "FlxWorld.h"
+#include "FlxProfiler.h"
+#include "FlxG.h"
+
+// entities per chunk
+static const unsigned int ChunkCapacity = 256;
+
+// entity = index (low bits) + generation (high bits)
+static const unsigned int IndexBits = 20;
+static const unsigned int IndexMask = (1 << IndexBits) - 1;
+static const unsigned int GenerationMask = (1 << (32 - IndexBits)) - 1;
+
+// last index is never used, so FLX_NO_ENTITY is never valid
+static const unsigned int MaxEntities = IndexMask;
+
+
+struct FlxWorld::Archetype {
+    unsigned int components;
+    std::vector<Chunk*> chunks;
+};
+
+
+struct FlxWorld::Chunk : public FlxWorldChunk {
+    Archetype *archetype;
+
+    Chunk(Archetype *owner) {
+        archetype = owner;
+        components = owner->components;
+        count = 0;
+
+        entities = new FlxEntity[ChunkCapacity];
+        transforms = (components & FLX_TRANSFORM) ? new FlxTransform[ChunkCapacity] : NULL;
+        velocities = (components & FLX_VELOCITY) ? new FlxVelocity[ChunkCapacity] : NULL;
+        hitboxes = (components & FLX_HITBOX) ? new FlxHitbox[ChunkCapacity] : NULL;
+        sprites = (components & FLX_SPRITE) ? new FlxSpriteRef[ChunkCapacity] : NULL;
+        animations = (components & FLX_ANIMATION) ? new FlxAnimation[ChunkCapacity] : NULL;
+    }
+
+    ~Chunk() {
+        delete[] entities;
+        delete[] transforms;
+        delete[] velocities;
+        delete[] hitboxes;
+        delete[] sprites;
+        delete[] animations;
+    }
+};
+
+
+/*
+*  Copy component between rows (if both chunks have it)
+*/
+template<class T> static void copyComponent(T *from, unsigned int fromRow, T *to, unsigned int toRow) {
+    if(from && to) to[toRow] = from[fromRow];
+}
+
+
+/*
+*  Copy all common components between rows
+*/
+static void copyRow(FlxWorldChunk *from, unsigned int fromRow, FlxWorldChunk *to, unsigned int toRow) {
+    copyComponent(from->transforms, fromRow, to->transforms, toRow);
+    copyComponent(from->velocities, fromRow, to->velocities, toRow);
+    copyComponent(from->hitboxes, fromRow, to->hitboxes, toRow);
+    copyComponent(from->sprites, fromRow, to->sprites, toRow);
+    copyComponent(from->animations, fromRow, to->animations, toRow);
+}
+
+
+FlxWorld::FlxWorld() {
+    entitiesCount = 0;
+    iterating = 0;
+    lastWorldUpdate = 0;
+    batchImage = NULL;
+    batchColor = 0xffffff;
+    batchAlpha = 1.f;
+
+    // world isn't a collider itself, use query() instead
+    collisions = false;
+}
+
+
+FlxWorld::~FlxWorld() {
+    for(unsigned int i = 0; i < archetypesList.size(); i++) {
+        Archetype *archetype = archetypesList[i];
+
+        for(unsigned int j = 0; j < archetype->chunks.size(); j++) {
+            delete archetype->chunks[j];
+        }
+
+        delete archetype;
+    }
+}
+
+
+FlxWorld::Archetype* FlxWorld::getArchetype(unsigned int components) {
+    std::map<unsigned int, Archetype*>::iterator it = archetypes.find(components);
+    if(it != archetypes.end()) return it->second;
+
+    Archetype *archetype = new Archetype();
+    archetype->components = components;
+
+    archetypes[components] = archetype;
+    archetypesList.push_back(archetype);
+
+    return archetype;
+}
+
+
+FlxWorld::Record* FlxWorld::getRecord(FlxEntity entity) {
+    unsigned int index = entity & IndexMask;
+    if(index >= records.size()) return NULL;
+
+    Record *record = &records[index];
+    if(!record->chunk || record->generation != (entity >> IndexBits)) return NULL;
+
+    return record;
+}
+
+
+FlxWorldChunk* FlxWorld::getChunk(Record *record) {
+    return record->chunk;
+}
+
+
+void FlxWorld::insert(FlxEntity entity, Archetype *archetype) {
+    Chunk *chunk = archetype->chunks.empty() ? NULL : archetype->chunks.back();
+
+    if(!chunk || chunk->count == ChunkCapacity) {
+        chunk = new Chunk(archetype);
+        archetype->chunks.push_back(chunk);
+    }
+
+    unsigned int row = chunk->count++;
+    chunk->entities[row] = entity;
+
+    // reused rows keep old values
+    if(chunk->transforms) chunk->transforms[row] = FlxTransform();
+    if(chunk->velocities) chunk->velocities[row] = FlxVelocity();
+    if(chunk->hitboxes) chunk->hitboxes[row] = FlxHitbox();
+    if(chunk->sprites) chunk->sprites[row] = FlxSpriteRef();
+    if(chunk->animations) chunk->animations[row] = FlxAnimation();
+
+    Record& record = records[entity & IndexMask];
+    record.chunk = chunk;
+    record.row = row;
+}
+
+
+void FlxWorld::removeRow(Chunk *chunk, unsigned int row) {
+    Archetype *archetype = chunk->archetype;
+    Chunk *last = archetype->chunks.back();
+    unsigned int lastRow = last->count - 1;
+
+    // fill the hole with last entity of archetype, so chunks stay dense
+    if(last != chunk || lastRow != row) {
+        FlxEntity moved = last->entities[lastRow];
+
+        chunk->entities[row] = moved;
+        copyRow(last, lastRow, chunk, row);
+
+        Record& record = records[moved & IndexMask];
+        record.chunk = chunk;
+        record.row = row;
+    }
+
+    last->count--;
+
+    if(last->count == 0 && archetype->chunks.size() > 1) {
+        delete last;
+        archetype->chunks.pop_back();
+    }
+}
+
+
+void FlxWorld::erase(FlxEntity entity) {
+    Record& record = records[entity & IndexMask];
+
+    removeRow(record.chunk, record.row);
+
+    record.chunk = NULL;
+    record.generation = (record.generation + 1) & GenerationMask;
+    freeIndices.push_back(entity & IndexMask);
+    entitiesCount--;
+}
+
+
+void FlxWorld::flushDestroyed() {
+    for(unsigned int i = 0; i < destroyQueue.size(); i++) {
+        if(getRecord(destroyQueue[i])) erase(destroyQueue[i]);
+    }
+
+    destroyQueue.clear();
+}
+
+
+FlxEntity FlxWorld::create(unsigned int components) {
+    unsigned int index;
+
+    if(!freeIndices.empty()) {
+        index = freeIndices.back();
+        freeIndices.pop_back();
+    }
+    else {
+        if(records.size() >= MaxEntities) {
+            std::cerr << "[Error] FlxWorld: Too many entities" << std::endl;
+            return FLX_NO_ENTITY;
+        }
+
+        index = records.size();
+
+        Record record;
+        record.chunk = NULL;
+        record.row = 0;
+        record.generation = 0;
+        records.push_back(record);
+    }
+
+    FlxEntity entity = (records[index].generation << IndexBits) | index;
+    insert(entity, getArchetype(components));
+    entitiesCount++;
+
+    return entity;
+}
+
+
+void FlxWorld::destroy(FlxEntity entity) {
+    if(!getRecord(entity)) return;
+
+    if(iterating > 0) {
+        destroyQueue.push_back(entity);
+        return;
+    }
+
+    erase(entity);
+}
+
+
+bool FlxWorld::isAlive(FlxEntity entity) {
+    return getRecord(entity) != NULL;
+}
+
+
+unsigned int FlxWorld::getComponents(FlxEntity entity) {
+    Record *record = getRecord(entity);
+    return record ? record->chunk->components : 0;
+}
+
+
+void FlxWorld::setComponents(FlxEntity entity, unsigned int components) {
+    Record *record = getRecord(entity);
+    if(!record || record->chunk->components == components) return;
+
+    if(iterating > 0) {
+        std::cerr << "[Error] FlxWorld: Can't change components while iterating" << std::endl;
+        return;
+    }
+
+    Chunk *oldChunk = record->chunk;
+    unsigned int oldRow = record->row;
+
+    insert(entity, getArchetype(components));
+    copyRow(oldChunk, oldRow, record->chunk, record->row);
+    removeRow(oldChunk, oldRow);
+}
+
+
+unsigned int FlxWorld::getEntitiesCount() {
+    return entitiesCount;
+}
+
+
+void FlxWorld::clear() {
+    for(unsigned int i = 0; i < records.size(); i++) {
+        Record& record = records[i];
+        if(!record.chunk) continue;
+
+        record.chunk = NULL;
+        record.generation = (record.generation + 1) & GenerationMask;
+        freeIndices.push_back(i);
+    }
+
+    // keep first chunk of every archetype, it will be filled again soon
+    for(unsigned int i = 0; i < archetypesList.size(); i++) {
+        std::vector<Chunk*>& chunks = archetypesList[i]->chunks;
+
+        for(unsigned int j = 1; j < chunks.size(); j++) {
+            delete chunks[j];
+        }
+
+        if(!chunks.empty()) {
+            chunks.resize(1);
+            chunks[0]->count = 0;
+        }
+    }
+
+    destroyQueue.clear();
+    entitiesCount = 0;
+}
+
+
+void FlxWorld::forEach(unsigned int components, const System& function) {
+    iterating++;
+
+    // indices, not iterators (function may create entities and archetypes)
+    for(unsigned int i = 0; i < archetypesList.size(); i++) {
+        Archetype *archetype = archetypesList[i];
+        if((archetype->components & components) != components) continue;
+
+        for(unsigned int j = 0; j < archetype->chunks.size(); j++) {
+            Chunk *chunk = archetype->chunks[j];
+            if(chunk->count > 0) function(*chunk);
+        }
+    }
+
+    iterating--;
+    if(iterating == 0) flushDestroyed();
+}
+
+
+void FlxWorld::addSystem(unsigned int components, const System& system) {
+    SystemEntry entry;
+    entry.components = components;
+    entry.system = system;
+
+    systems.push_back(entry);
+}
+
+
+void FlxWorld::query(const FlxRect& rect, std::vector<FlxEntity>& result) {
+    for(unsigned int i = 0; i < archetypesList.size(); i++) {
+        Archetype *archetype = archetypesList[i];
+        if(!(archetype->components & FLX_HITBOX)) continue;
+
+        for(unsigned int j = 0; j < archetype->chunks.size(); j++) {
+            Chunk *chunk = archetype->chunks[j];
+
+            for(unsigned int k = 0; k < chunk->count; k++) {
+                if(chunk->hitboxes[k].rect.overlaps(rect)) result.push_back(chunk->entities[k]);
+            }
+        }
+    }
+}
+
+
+void FlxWorld::updateMotion(FlxWorldChunk& chunk, float dt) {
+    FlxTransform *t = chunk.transforms;
+    FlxVelocity *v = chunk.velocities;
+    unsigned int count = chunk.count;
+
+    for(unsigned int i = 0; i < count; i++) {
+        t[i].lastX = t[i].x;
+        t[i].lastY = t[i].y;
+    }
+
+    if(!v) return;
+
+    for(unsigned int i = 0; i < count; i++) {
+        t[i].x += v[i].velocity.x * dt;
+        t[i].y += v[i].velocity.y * dt;
+        v[i].velocity.x += v[i].acceleration.x * dt;
+        v[i].velocity.y += v[i].acceleration.y * dt;
+
+        if(v[i].velocity.x > v[i].maxVelocity.x) v[i].velocity.x = v[i].maxVelocity.x;
+        if(v[i].velocity.y > v[i].maxVelocity.y) v[i].velocity.y = v[i].maxVelocity.y;
+        if(v[i].velocity.x < -v[i].maxVelocity.x) v[i].velocity.x = -v[i].maxVelocity.x;
+        if(v[i].velocity.y < -v[i].maxVelocity.y) v[i].velocity.y = -v[i].maxVelocity.y;
+
+        t[i].angle += v[i].angularVelocity * dt;
+    }
+}
+
+
+void FlxWorld::updateHitboxes(FlxWorldChunk& chunk) {
+    FlxTransform *t = chunk.transforms;
+    FlxHitbox *h = chunk.hitboxes;
+
+    for(unsigned int i = 0; i < chunk.count; i++) {
+        h[i].rect.x = t[i].x + h[i].offset.x;
+        h[i].rect.y = t[i].y + h[i].offset.y;
+    }
+}
+
+
+void FlxWorld::updateAnimations(FlxWorldChunk& chunk, float dt) {
+    FlxSpriteRef *s = chunk.sprites;
+    FlxAnimation *a = chunk.animations;
+
+    for(unsigned int i = 0; i < chunk.count; i++) {
+        FlxAnimation& anim = a[i];
+        if(anim.finished || anim.frameTime <= 0 || anim.framesCount == 0) continue;
+
+        anim.counter += dt;
+        if(anim.counter < anim.frameTime) continue;
+
+        while(anim.counter >= anim.frameTime) {
+            anim.counter -= anim.frameTime;
+            anim.currentFrame++;
+
+            if(anim.currentFrame >= anim.framesCount) {
+                if(anim.looped) {
+                    anim.currentFrame = 0;
+                }
+                else {
+                    anim.currentFrame = anim.framesCount - 1;
+                    anim.finished = true;
+                    break;
+                }
+            }
+        }
+
+        // the same layout as FlxSprite::calcFrame()
+        FlxSpriteRef& sprite = s[i];
+        if(!sprite.image || sprite.source.width <= 0) continue;
+
+        int imgWidth = sprite.image->getWidth();
+        int frame = (int)(anim.firstFrame + anim.currentFrame);
+        int rx = frame * sprite.source.width;
+        int ry = 0;
+
+        if(rx >= imgWidth) {
+            ry = (rx / imgWidth) * sprite.source.height;
+            rx %= imgWidth;
+        }
+
+        sprite.source.x = (float)rx;
+        sprite.source.y = (float)ry;
+    }
+}
+
+
+void FlxWorld::update() {
+    if(!active) return;
+
+    FLX_PROFILE_ZONE("FlxWorld::update");
+
+    float dt = FlxG::fixedTime;
+    lastWorldUpdate = FlxG::updatesCount;
+
+    iterating++;
+
+    // built-in systems, all of them on one chunk while it's in cache
+    for(unsigned int i = 0; i < archetypesList.size(); i++) {
+        Archetype *archetype = archetypesList[i];
+        unsigned int components = archetype->components;
+
+        for(unsigned int j = 0; j < archetype->chunks.size(); j++) {
+            Chunk *chunk = archetype->chunks[j];
+            if(chunk->count == 0) continue;
+
+            if(components & FLX_TRANSFORM) {
+                updateMotion(*chunk, dt);
+                if(components & FLX_HITBOX) updateHitboxes(*chunk);
+            }
+
+            if((components & FLX_SPRITE) && (components & FLX_ANIMATION)) {
+                updateAnimations(*chunk, dt);
+            }
+        }
+    }
+
+    for(unsigned int i = 0; i < systems.size(); i++) {
+        forEach(systems[i].components, systems[i].system);
+    }
+
+    iterating--;
+    flushDestroyed();
+}
+
+
+void FlxWorld::flushBatch() {
+    if(batch.empty()) return;
+
+    FlxG::renderer.drawImages(batchImage, &batch[0], batch.size(), batchScale, batchColor, batchAlpha);
+    batch.clear();
+}
+
+
+void FlxWorld::drawSprites(FlxWorldChunk& chunk, const FlxVector& move, bool interpolate) {
+    FlxTransform *t = chunk.transforms;
+    FlxSpriteRef *s = chunk.sprites;
+    float alpha = FlxG::interpolationAlpha;
+
+    for(unsigned int i = 0; i < chunk.count; i++) {
+        FlxSpriteRef& sprite = s[i];
+        if(!sprite.visible || !sprite.image) continue;
+
+        // one batch per run of sprites with the same image and state
+        if(sprite.image != batchImage || sprite.color != batchColor || sprite.alpha != batchAlpha ||
+           sprite.scale.x != batchScale.x || sprite.scale.y != batchScale.y)
+        {
+            flushBatch();
+
+            batchImage = sprite.image;
+            batchColor = sprite.color;
+            batchAlpha = sprite.alpha;
+            batchScale = sprite.scale;
+        }
+
+        FlxBatchSprite drawn;
+        drawn.x = t[i].x;
+        drawn.y = t[i].y;
+
+        if(interpolate) {
+            drawn.x = t[i].lastX + (t[i].x - t[i].lastX) * alpha;
+            drawn.y = t[i].lastY + (t[i].y - t[i].lastY) * alpha;
+        }
+
+        drawn.x += move.x;
+        drawn.y += move.y;
+        drawn.angle = t[i].angle;
+        drawn.source = sprite.source;
+
+        batch.push_back(drawn);
+    }
+}
+
+
+void FlxWorld::draw() {
+    if(!visible || entitiesCount == 0) return;
+
+    FLX_PROFILE_ZONE("FlxWorld::draw");
+
+    FlxVector move = FlxG::scroolVector;
+    move.x *= scroolFactor.x;
+    move.y *= scroolFactor.y;
+    if(!scrool) { move.x = move.y = 0; }
+
+    // entities not updated in last step are standing still
+    bool interpolate = FlxG::interpolation && lastWorldUpdate == FlxG::updatesCount;
+
+    for(unsigned int i = 0; i < archetypesList.size(); i++) {
+        Archetype *archetype = archetypesList[i];
+        if((archetype->components & (FLX_TRANSFORM | FLX_SPRITE)) != (FLX_TRANSFORM | FLX_SPRITE)) continue;
+
+        for(unsigned int j = 0; j < archetype->chunks.size(); j++) {
+            drawSprites(*archetype->chunks[j], move, interpolate);
+        }
+    }
+
+    flushBatch();
+    batchImage = NULL;
+}
@@ -0,0 +1,648 @@
+#include "backend/headless/Backend.h"
+#include "FlxG.h"
+#include <chrono>
+
+
+// nanoseconds from some point in the past
+static unsigned long long HeadlessNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+
+/*
+*  Headless image class (metadata only)
+*/
+class Headless_Image : public FlxBackendImage {
+
+public:
+    int width, height;
+
+    int getWidth() {
+        return width;
+    }
+
+    int getHeight() {
+        return height;
+    }
+
+    int getFormat() {
+        return 0; // default
+    }
+};
+
+
+/*
+*  Headless font class (metadata only)
+*/
+struct Headless_Font {
+    std::string path;
+    int size;
+};
+
+
+/*
+*  Headless shader class
+*/
+class Headless_Shader : public FlxBackendShader {
+
+public:
+    virtual void setParameter(const char*, float) {
+    }
+
+    virtual void setParameter(const char*, float, float) {
+    }
+
+    virtual void setParameter(const char*, float, float, float) {
+    }
+
+    virtual void setParameter(const char*, float, float, float, float) {
+    }
+
+    virtual void setParameter(const char*, FlxBackendImage*) {
+    }
+};
+
+
+/*
+*  In-memory file
+*/
+class Headless_File : public FlxBackendFile {
+
+private:
+    std::string *buffer;
+    unsigned int position;
+public:
+    Headless_File(std::string *data) {
+        buffer = data;
+        position = 0;
+    }
+
+    virtual bool open(const char *path, const char *mode, bool internal) {
+        (void)path; (void)internal;
+
+        if(strchr(mode, 'w')) buffer->clear();
+        if(strchr(mode, 'a')) position = buffer->size();
+        return true;
+    }
+
+    virtual bool eof() {
+        return position >= buffer->size();
+    }
+
+    virtual unsigned int tell() {
+        return position;
+    }
+
+    virtual void seek(long offset, int origin) {
+        long pos = offset;
+        if(origin == SEEK_CUR) pos += position;
+        else if(origin == SEEK_END) pos += buffer->size();
+
+        if(pos < 0) pos = 0;
+        position = (unsigned int)pos;
+    }
+
+    virtual void write(const char *data, unsigned int size) {
+        if(position > buffer->size()) buffer->resize(position);
+
+        buffer->replace(position, std::min<size_t>(size, buffer->size() - position), data, size);
+        position += size;
+    }
+
+    virtual int read(char *data, unsigned int maxSize) {
+        if(position >= buffer->size()) return 0;
+
+        unsigned int toRead = std::min<unsigned int>(maxSize, buffer->size() - position);
+        memcpy(data, buffer->data() + position, toRead);
+        position += toRead;
+
+        return toRead;
+    }
+
+    virtual void close() {
+    }
+};
+
+
+/*
+*  Headless sound class. It "plays" for some simulated time.
+*/
+class Headless_Sound : public FlxBackendSound {
+
+public:
+    Headless_Backend *owner;
+    float length;
+    double endTime;
+    bool looped, playing;
+
+    virtual void setSound(void *sound) {
+        (void)sound;
+        playing = false;
+    }
+
+    virtual void play() {
+        playing = true;
+        endTime = owner->getTime() + length;
+    }
+
+    virtual void stop() {
+        playing = false;
+    }
+
+    virtual void setLoop(bool t) {
+        looped = t;
+    }
+
+    virtual void setVolume(float vol) {
+        (void)vol;
+    }
+
+    virtual bool isPlaying() {
+        return playing && (looped || owner->getTime() < endTime);
+    }
+};
+
+
+/*
+*  Headless music class. It plays until stopped.
+*/
+class Headless_Music : public FlxBackendMusic {
+
+public:
+    bool playing;
+
+    virtual void play() {
+        playing = true;
+    }
+
+    virtual void stop() {
+        playing = false;
+    }
+
+    virtual void setLoop(bool t) {
+        (void)t;
+    }
+
+    virtual void setVolume(float vol) {
+        (void)vol;
+    }
+
+    virtual bool isPlaying() {
+        return playing;
+    }
+};
+
+
+
+/*
+*  Main backend class definition
+*/
+Headless_Backend::Headless_Backend(unsigned int frames) {
+    maxFrames = frames;
+    frame = 0;
+    frameTime = 0;
+    currentTime = 0;
+    soundLength = 1.f;
+    width = height = 0;
+    defaultImageWidth = defaultImageHeight = 32;
+    lastTexture = NULL;
+
+    for(int i = 0; i < 1024; i++) {
+        keysDown[i] = false;
+    }
+
+    mouseButtons[0] = mouseButtons[1] = mouseButtons[2] = false;
+    resetStats();
+}
+
+bool Headless_Backend::setupSurface(const char *title, int Width, int Height, const char *icon) {
+    (void)title; (void)icon;
+
+    width = Width;
+    height = Height;
+    currentTime = 0;
+    lastTexture = NULL;
+
+    FlxMouse::onTouchBegin(0, mousePosition.x, mousePosition.y);
+    return true;
+}
+
+void Headless_Backend::mainLoop(void (*onUpdate)(), void (*onDraw)()) {
+    frame = 0;
+    FlxBackendBase::mainLoop(onUpdate, onDraw);
+}
+
+bool Headless_Backend::isRunning() {
+    return maxFrames == 0 || frame < maxFrames;
+}
+
+void Headless_Backend::beginFrame() {
+
+    // simulated time
+    currentTime += (frameTime > 0) ? frameTime : FlxG::fixedTime;
+
+    frameStart = HeadlessNow();
+}
+
+void Headless_Backend::updateEvents() {
+    pendingUpdates++;
+}
+
+void Headless_Backend::beginDraw() {
+    lastTexture = NULL;
+    drawStart = HeadlessNow();
+}
+
+void Headless_Backend::endDraw() {
+    unsigned long long end = HeadlessNow();
+
+    unsigned long long start = frameStart;
+
+    // save frame statistics
+    totalStats.frames++;
+    totalStats.updates += pendingUpdates.exchange(0);
+    totalStats.bytesUploaded += pendingUploads.exchange(0);
+    totalStats.updateTime += drawStart - start;
+    totalStats.drawTime += end - drawStart;
+
+    frameStats.frames = 1;
+    frameStats.updates = totalStats.updates - lastStats.updates;
+    frameStats.drawCalls = totalStats.drawCalls - lastStats.drawCalls;
+    frameStats.textDraws = totalStats.textDraws - lastStats.textDraws;
+    frameStats.shaderDraws = totalStats.shaderDraws - lastStats.shaderDraws;
+    frameStats.textureSwitches = totalStats.textureSwitches - lastStats.textureSwitches;
+    frameStats.bytesUploaded = totalStats.bytesUploaded - lastStats.bytesUploaded;
+    frameStats.updateTime = drawStart - start;
+    frameStats.drawTime = end - drawStart;
+
+    lastStats = totalStats;
+
+    frame++;
+    if(frameCallback != nullptr) frameCallback(this);
+}
+
+FlxVector Headless_Backend::getScreenSize() {
+    return FlxVector((float)width, (float)height);
+}
+
+void Headless_Backend::exitApplication() {
+
+    for(std::map<std::string, FlxBackendImage*>::iterator it = images.begin(); it != images.end(); it++) {
+        delete (Headless_Image*) it->second;
+    }
+
+    for(unsigned int i = 0; i < createdImages.size(); i++) {
+        delete (Headless_Image*) createdImages[i];
+    }
+
+    for(std::map<std::string, void*>::iterator it = fonts.begin(); it != fonts.end(); it++) {
+        delete (Headless_Font*) it->second;
+    }
+
+    for(std::map<std::string, void*>::iterator it = sounds.begin(); it != sounds.end(); it++) {
+        delete (std::string*) it->second;
+    }
+
+    for(unsigned int i = 0; i < shaders.size(); i++) {
+        delete shaders[i];
+    }
+
+    images.clear();
+    createdImages.clear();
+    fonts.clear();
+    sounds.clear();
+    shaders.clear();
+
+    FlxMouse::onTouchEnd(0, 0, 0);
+}
+
+bool* Headless_Backend::getKeysDown() {
+    return keysDown;
+}
+
+bool Headless_Backend::isKeyDown(int code) {
+    if(code < 0 || code >= 1024) return false;
+    return keysDown[code];
+}
+
+FlxVector Headless_Backend::getMousePosition(int index) {
+    (void)index;
+    return mousePosition;
+}
+
+bool Headless_Backend::getMouseButtonState(int button, int index) {
+    (void)index;
+
+    if(button < 0 || button > 2) return false;
+    return mouseButtons[button];
+}
+
+void Headless_Backend::showMouse(bool show) {
+    (void)show;
+}
+
+void Headless_Backend::bindTexture(void *texture) {
+    if(texture != lastTexture) {
+        lastTexture = texture;
+        totalStats.textureSwitches++;
+    }
+}
+
+void Headless_Backend::drawImage(FlxBackendImage *img, float x, float y, const FlxVector& scale, float angle,
+                                 const FlxRect& source, int color, bool flipped, float alpha)
+{
+    (void)x; (void)y; (void)scale; (void)angle; (void)source; (void)color; (void)flipped; (void)alpha;
+    if(!img) return;
+
+    bindTexture(img);
+    totalStats.drawCalls++;
+}
+
+void Headless_Backend::drawImages(FlxBackendImage *img, const FlxBatchSprite *sprites, unsigned int count,
+                                  const FlxVector& scale, int color, float alpha)
+{
+    (void)sprites; (void)scale; (void)color; (void)alpha;
+    if(!img || count == 0) return;
+
+    // whole batch is one draw call with one texture
+    bindTexture(img);
+    totalStats.drawCalls++;
+}
+
+FlxBaseText *Headless_Backend::createText(const wchar_t *text, void *font, int size, int color, float alpha) {
+    if(!font) return NULL;
+
+    FlxBaseText *data = new FlxBaseText();
+    data->data = NULL;
+    data->font = font;
+    data->size = size;
+    data->color = color;
+    data->alpha = alpha;
+    data->text = text;
+
+    // rough estimation of rendered text size
+    data->bounds.x = (float)(data->text.length() * size / 2);
+    data->bounds.y = (float)size;
+
+    pendingUploads += (unsigned long long)(data->bounds.x * data->bounds.y) * 4;
+    return data;
+}
+
+void Headless_Backend::destroyText(FlxBaseText *data) {
+    if(data) delete data;
+}
+
+void Headless_Backend::drawText(FlxBaseText *text, float x, float y, const FlxVector& scale, float angle) {
+    (void)x; (void)y; (void)scale; (void)angle;
+    if(!text) return;
+
+    bindTexture(text->font);
+    totalStats.drawCalls++;
+    totalStats.textDraws++;
+}
+
+FlxBackendImage* Headless_Backend::createImage(int Width, int Height, int color, float alpha) {
+    (void)color; (void)alpha;
+
+    Headless_Image *img = new Headless_Image();
+    img->width = Width;
+    img->height = Height;
+
+    FlxLock lock(assetsMutex);
+    createdImages.push_back(img);
+    pendingUploads += (unsigned long long)Width * Height * 4;
+    return img;
+}
+
+bool Headless_Backend::readImageSize(const char *path, int &w, int &h) {
+
+    // forced size?
+    if(imageSizes.find(path) != imageSizes.end()) {
+        w = imageSizes[path].first;
+        h = imageSizes[path].second;
+        return true;
+    }
+
+    // read PNG header (signature + IHDR chunk)
+    unsigned char header[24];
+    std::string *data = findFile(path, "rb");
+    if(!data) return false;
+
+    int bytes = (data->size() < sizeof(header)) ? data->size() : sizeof(header);
+    memcpy(header, data->data(), bytes);
+
+    if(bytes != sizeof(header) || header[0] != 0x89 || header[1] != 'P' || header[2] != 'N' ||
+       header[3] != 'G' || memcmp(header + 12, "IHDR", 4) != 0)
+    {
+        return false;
+    }
+
+    w = (header[16] << 24) | (header[17] << 16) | (header[18] << 8) | header[19];
+    h = (header[20] << 24) | (header[21] << 16) | (header[22] << 8) | header[23];
+    return true;
+}
+
+FlxBackendImage *Headless_Backend::loadImage(const char *path) {
+    FlxLock lock(assetsMutex);
+
+    if(images.find(path) != images.end()) {
+        return images[path];
+    }
+
+    Headless_Image *img = new Headless_Image();
+    if(!readImageSize(path, img->width, img->height)) {
+        img->width = defaultImageWidth;
+        img->height = defaultImageHeight;
+    }
+
+    images[path] = img;
+    pendingUploads += (unsigned long long)img->width * img->height * 4;
+    return img;
+}
+
+void *Headless_Backend::loadFont(const char *path, int fontSize) {
+
+    std::stringstream ss;
+    ss << path << "__size_" << fontSize;
+
+    FlxLock lock(assetsMutex);
+
+    if(fonts.find(ss.str()) != fonts.end()) {
+        return fonts[ss.str()];
+    }
+
+    Headless_Font *font = new Headless_Font();
+    font->path = path;
+    font->size = fontSize;
+
+    fonts[ss.str()] = font;
+    return font;
+}
+
+bool Headless_Backend::isShadersSupported() {
+    return true;
+}
+
+FlxBackendShader* Headless_Backend::loadShader(const char *path) {
+    (void)path;
+
+    Headless_Shader *shader = new Headless_Shader();
+
+    FlxLock lock(assetsMutex);
+    shaders.push_back(shader);
+    return shader;
+}
+
+void Headless_Backend::drawShader(FlxBackendShader *s) {
+    if(!s) return;
+
+    lastTexture = NULL;
+    totalStats.drawCalls++;
+    totalStats.shaderDraws++;
+}
+
+void* Headless_Backend::loadSound(const char *path) {
+    FlxLock lock(assetsMutex);
+
+    if(sounds.find(path) != sounds.end()) {
+        return sounds[path];
+    }
+
+    std::string *sound = new std::string(path);
+    sounds[path] = sound;
+    return sound;
+}
+
+FlxBackendMusic* Headless_Backend::loadMusic(const char *path) {
+    (void)path;
+
+    Headless_Music *m = new Headless_Music();
+    m->playing = false;
+    return m;
+}
+
+FlxBackendSound* Headless_Backend::createSound() {
+    Headless_Sound *s = new Headless_Sound();
+    s->owner = this;
+    s->length = soundLength;
+    s->looped = false;
+    s->playing = false;
+
+    return s;
+}
+
+void Headless_Backend::playMusic(FlxBackendMusic *buff, float vol) {
+    if(!buff) return;
+
+    buff->setVolume(vol);
+    buff->play();
+}
+
+// in-memory file I/O (existing files are read from disk on first access)
+std::string* Headless_Backend::findFile(const char *path, const char *mode) {
+
+    if(files.find(path) == files.end()) {
+        if(strchr(mode, 'r')) {
+            std::ifstream in(path, std::ios::in | std::ios::binary);
+            if(!in) return NULL;
+
+            std::stringstream ss;
+            ss << in.rdbuf();
+            files[path] = ss.str();
+        }
+        else {
+            files[path] = "";
+        }
+    }
+
+    return &files[path];
+}
+
+FlxBackendFile* Headless_Backend::openFile(const char *path, const char *mode, bool internal) {
+    FlxLock lock(assetsMutex);
+
+    std::string *data = findFile(path, mode);
+    if(!data) return NULL;
+
+    Headless_File *file = new Headless_File(data);
+    file->open(path, mode, internal);
+    return file;
+}
+
+bool Headless_Backend::sendHttpRequest(FlxHttpRequest *req, FlxHttpResponse& resp) {
+    (void)req;
+
+    resp.code = 1001; // connection failed
+    resp.data.clear();
+    return false;
+}
+
+void Headless_Backend::setMaxFrames(unsigned int frames) {
+    maxFrames = frames;
+}
+
+void Headless_Backend::setFrameTime(float seconds) {
+    frameTime = seconds;
+}
+
+double Headless_Backend::getTime() {
+    return currentTime;
+}
+
+void Headless_Backend::setDefaultImageSize(int Width, int Height) {
+    defaultImageWidth = Width;
+    defaultImageHeight = Height;
+}
+
+void Headless_Backend::registerImage(const char *path, int Width, int Height) {
+    FlxLock lock(assetsMutex);
+    imageSizes[path] = std::make_pair(Width, Height);
+}
+
+void Headless_Backend::setSoundLength(float seconds) {
+    soundLength = seconds;
+}
+
+void Headless_Backend::addFile(const char *path, const std::string& data) {
+    FlxLock lock(assetsMutex);
+    files[path] = data;
+}
+
+bool Headless_Backend::getFile(const char *path, std::string& data) {
+    FlxLock lock(assetsMutex);
+
+    if(files.find(path) == files.end()) return false;
+
+    data = files[path];
+    return true;
+}
+
+void Headless_Backend::setKeyDown(int code, bool down) {
+    if(code < 0 || code >= 1024) return;
+    keysDown[code] = down;
+}
+
+void Headless_Backend::setMousePosition(float x, float y) {
+    mousePosition.x = x;
+    mousePosition.y = y;
+}
+
+void Headless_Backend::setMouseButton(int button, bool down) {
+    if(button < 0 || button > 2) return;
+    mouseButtons[button] = down;
+}
+
+void Headless_Backend::resetStats() {
+    memset(&frameStats, 0, sizeof(frameStats));
+    memset(&totalStats, 0, sizeof(totalStats));
+    memset(&lastStats, 0, sizeof(lastStats));
+
+    frameStart = 0;
+    pendingUpdates = 0;
+    pendingUploads = 0;
+}
+
+void Headless_Backend::setFrameCallback(const FrameCallback& callback) {
+    frameCallback = callback;
+}
@@ -227,32 +227,35 @@ class SDL_Sound : public FlxBackendSound {
 
 public:
     Mix_Chunk *buffer;
-	int channel;
+	int channel;    // every voice owns its own mixer channel
+	bool looped;
 
     virtual ~SDL_Sound() {
         stop();
     }
 
-    virtual void play() {
+    virtual void setSound(void *sound) {
+		stop();
+		buffer = (Mix_Chunk*) sound;
+    }
 
-		if(isPlaying()) {
-			stop();
-		}
+    virtual void play() {
+		if(!buffer) return;
 
-		channel = Mix_PlayChannel(-1, buffer, 0);
+		Mix_PlayChannel(channel, buffer, looped ? -1 : 0);
     }
 
     virtual void stop() {
 		Mix_HaltChannel(channel);
-		channel = -1;
     }
 
     virtual void setLoop(bool t) {
-		// not implemented yet
+		// applied on next play()
+		looped = t;
     }
 
     virtual void setVolume(float vol) {
-        if(buffer) Mix_VolumeChunk(buffer, int(vol * 128.f));
+        Mix_Volume(channel, int(vol * 128.f));
     }
 
     virtual bool isPlaying() {
@@ -377,6 +380,7 @@ bool SDL_Mobile_Backend::setupSurface(const char *title, int width, int height,
 	int audio_buffers = 4096;
 
 	Mix_OpenAudio(audio_rate, audio_format, audio_channels, audio_buffers);
+	soundChannels = 0;
 
     for(int i = 0; i < 1024; i++) {
         keysDown[i] = false;
@@ -401,39 +405,22 @@ bool SDL_Mobile_Backend::setupSurface(const char *title, int width, int height,
     return true;
 }
 
-void SDL_Mobile_Backend::mainLoop(void (*onUpdate)(), void (*onDraw)()) {
-
-    float currentTime = (float)SDL_GetTicks() / 1000.f;
-    float accumulator = 0;
-
-    while(!FlxG::exitMessage && !exitMsg) {
-
-        // fixed timestep stuff
-        float newTime = (float)SDL_GetTicks() / 1000.f;
-        float elapsed = newTime - currentTime;
-        currentTime = newTime;
-
-        accumulator += elapsed;
-
-        while(accumulator >= FlxG::fixedTime) {
-
-            // update all stuff
-            updateEvents();
-            onUpdate();
-
-            accumulator -= FlxG::fixedTime;
-        }
-
-		SDL_SetRenderDrawColor(renderer, COLOR_GET_R(FlxG::bgColor), COLOR_GET_G(FlxG::bgColor),
-                        COLOR_GET_B(FlxG::bgColor), 255);
-		SDL_RenderClear(renderer);
+bool SDL_Mobile_Backend::isRunning() {
+    return !exitMsg;
+}
 
-		onDraw();
+double SDL_Mobile_Backend::getTime() {
+    return SDL_GetTicks() / 1000.0;
+}
 
-		SDL_RenderPresent(renderer);
+void SDL_Mobile_Backend::beginDraw() {
+	SDL_SetRenderDrawColor(renderer, COLOR_GET_R(FlxG::bgColor), COLOR_GET_G(FlxG::bgColor),
+                    COLOR_GET_B(FlxG::bgColor), 255);
+	SDL_RenderClear(renderer);
+}
 
-        FlxG::elapsed = elapsed;
-    }
+void SDL_Mobile_Backend::endDraw() {
+	SDL_RenderPresent(renderer);
 }
 
 FlxVector SDL_Mobile_Backend::getScreenSize() {
@@ -812,15 +799,17 @@ FlxBackendMusic* SDL_Mobile_Backend::loadMusic(const char *path) {
     return m;
 }
 
-FlxBackendSound* SDL_Mobile_Backend::playSound(void *buffer, float vol) {
-	if(!buffer) return NULL;
+FlxBackendSound* SDL_Mobile_Backend::createSound() {
 
-	SDL_Sound *sound = new SDL_Sound();
-	sound->buffer = (Mix_Chunk*) buffer;
-	sound->channel = -1;
+	// allocate mixer channel for new voice
+	if(Mix_AllocateChannels(-1) <= soundChannels) {
+		Mix_AllocateChannels(soundChannels + 1);
+	}
 
-	sound->setVolume(vol);
-	sound->play();
+	SDL_Sound *sound = new SDL_Sound();
+	sound->buffer = NULL;
+	sound->channel = soundChannels++;
+	sound->looped = false;
 
     return sound;
 }
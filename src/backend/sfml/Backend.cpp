@@ -172,6 +172,11 @@ public:
         stop();
     }
 
+    virtual void setSound(void *sound) {
+        Track.Stop();
+        if(sound) Track.SetBuffer(*((sf::SoundBuffer*) sound));
+    }
+
     virtual void play() {
         Track.Play();
     }
@@ -185,7 +190,7 @@ public:
     }
 
     virtual void setVolume(float vol) {
-        vol *= 100.f;
+        Track.SetVolume(vol * 100.f);
     }
 
     virtual bool isPlaying() {
@@ -278,37 +283,21 @@ bool SFML_Backend::setupSurface(const char *title, int width, int height, const
     return true;
 }
 
-void SFML_Backend::mainLoop(void (*onUpdate)(), void (*onDraw)()) {
-
-    float currentTime = (float)clock.GetElapsedTime();
-    float accumulator = 0;
-
-    while(window->IsOpened() && !FlxG::exitMessage) {
-
-        // fixed timestep stuff
-        float newTime = (float)clock.GetElapsedTime();
-        float elapsed = newTime - currentTime;
-        currentTime = newTime;
-
-        accumulator += elapsed;
-
-        while(accumulator >= FlxG::fixedTime) {
-
-            // update all stuff
-            updateEvents();
-            onUpdate();
+bool SFML_Backend::isRunning() {
+    return window->IsOpened();
+}
 
-            accumulator -= FlxG::fixedTime;
-        }
+double SFML_Backend::getTime() {
+    return clock.GetElapsedTime();
+}
 
-        // render
-        window->Clear(sf::Color(COLOR_GET_R(FlxG::bgColor), COLOR_GET_G(FlxG::bgColor),
-                        COLOR_GET_B(FlxG::bgColor), 255));
-        onDraw();
-        window->Display();
+void SFML_Backend::beginDraw() {
+    window->Clear(sf::Color(COLOR_GET_R(FlxG::bgColor), COLOR_GET_G(FlxG::bgColor),
+                    COLOR_GET_B(FlxG::bgColor), 255));
+}
 
-        FlxG::elapsed = elapsed;
-    }
+void SFML_Backend::endDraw() {
+    window->Display();
 }
 
 FlxVector SFML_Backend::getScreenSize() {
@@ -459,6 +448,91 @@ void SFML_Backend::drawImage(FlxBackendImage *img, float x, float y, const FlxVe
     glPopMatrix();
 }
 
+void SFML_Backend::drawImages(FlxBackendImage *img, const FlxBatchSprite *sprites, unsigned int count,
+                              const FlxVector& scale, int color, float alpha)
+{
+    if(!img || count == 0) return;
+
+    SFML_Image *gfx = (SFML_Image*)img;
+    float texWidth = (float)gfx->getWidth();
+    float texHeight = (float)gfx->getHeight();
+
+    batchVertices.resize(count * 8);
+    batchTexCoords.resize(count * 8);
+    batchColors.resize(count * 16);
+
+    unsigned char r = COLOR_GET_R(color);
+    unsigned char g = COLOR_GET_G(color);
+    unsigned char b = COLOR_GET_B(color);
+    unsigned char a = static_cast<unsigned char>(alpha * 255.f);
+
+    // the same transformation as in drawImage, but done on CPU, so whole batch is one draw call
+    for(unsigned int i = 0; i < count; i++) {
+        const FlxBatchSprite& sprite = sprites[i];
+
+        float halfWidth = sprite.source.width / 2.f;
+        float halfHeight = sprite.source.height / 2.f;
+        float centerX = sprite.x + halfWidth;
+        float centerY = sprite.y + halfHeight;
+        float c = std::cos(sprite.angle);
+        float s = std::sin(sprite.angle);
+
+        float corners[] = {
+            -halfWidth, -halfHeight,
+            halfWidth, -halfHeight,
+            halfWidth, halfHeight,
+            -halfWidth, halfHeight
+        };
+
+        float *vertices = &batchVertices[i * 8];
+
+        for(int j = 0; j < 4; j++) {
+            float cx = corners[j * 2], cy = corners[j * 2 + 1];
+
+            vertices[j * 2] = centerX + (cx * c - cy * s) * scale.x;
+            vertices[j * 2 + 1] = centerY + (cx * s + cy * c) * scale.y;
+        }
+
+        float left = sprite.source.x / texWidth;
+        float top = sprite.source.y / texHeight;
+        float right = (sprite.source.x + sprite.source.width) / texWidth;
+        float bottom = (sprite.source.y + sprite.source.height) / texHeight;
+
+        float *texCoords = &batchTexCoords[i * 8];
+        texCoords[0] = left;  texCoords[1] = top;
+        texCoords[2] = right; texCoords[3] = top;
+        texCoords[4] = right; texCoords[5] = bottom;
+        texCoords[6] = left;  texCoords[7] = bottom;
+
+        unsigned char *colors = &batchColors[i * 16];
+
+        for(int j = 0; j < 4; j++) {
+            colors[j * 4] = r;
+            colors[j * 4 + 1] = g;
+            colors[j * 4 + 2] = b;
+            colors[j * 4 + 3] = a;
+        }
+    }
+
+    gfx->Graphic.Bind();
+
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(2, GL_FLOAT, 0, &batchVertices[0]);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glTexCoordPointer(2, GL_FLOAT, 0, &batchTexCoords[0]);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glColorPointer(4, GL_UNSIGNED_BYTE, 0, &batchColors[0]);
+
+    glDrawArrays(GL_QUADS, 0, count * 4);
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glDisableClientState(GL_COLOR_ARRAY);
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glDisable(GL_TEXTURE_2D);
+}
+
 FlxBaseText *SFML_Backend::createText(const wchar_t *text, void *font, int size, int color, float alpha) {
     if(!font) return NULL;
 
@@ -708,17 +782,8 @@ FlxBackendMusic* SFML_Backend::loadMusic(const char *path) {
     return m;
 }
 
-FlxBackendSound* SFML_Backend::playSound(void *sound, float vol) {
-
-    sf::SoundBuffer *buffer = (sf::SoundBuffer*) sound;
-
-    SFML_Sound *s = new SFML_Sound();
-    s->Track.SetBuffer(*buffer);
-    s->setVolume(vol);
-
-    s->play();
-
-    return s;
+FlxBackendSound* SFML_Backend::createSound() {
+    return new SFML_Sound();
 }
 
 void SFML_Backend::playMusic(FlxBackendMusic *buff, float vol) {
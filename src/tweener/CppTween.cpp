@@ -314,9 +314,10 @@ namespace tween {
                                     }
                                 }
                                 else {
-                                    (*tweensIT).cleanProperties();
-                                    tweens.erase(tweensIT);
-                                    --total_tweens;
+                                    // remove all tweens (erasing in loop invalidates iterator)
+                                    tweens.clear();
+                                    total_tweens = 0;
+                                    break;
                                 }
                         }
 